@@ -0,0 +1,73 @@
+#include "benchmark.h"
+#include "../libchromecast/json_arena.h"
+
+#include <new>
+#include <atomic>
+#include <cstdlib>
+
+//replaces the global allocation functions of the benchmark executables, the library linked into them allocates through these as well.
+static std::atomic<uint64_t> g_allocations(0);
+static std::atomic<uint64_t> g_allocated_bytes(0);
+//the folded bytes of the results kept by the benchmarks, an atomic since the benchmark threads keep results concurrently.
+static std::atomic<unsigned char> g_escaped_bytes(0);
+
+//rapidjson and the json arenas take their memory from malloc, JsonHeapAllocator reports those blocks here.
+static void CountJsonAllocation(size_t size)
+{
+	++g_allocations;
+	g_allocated_bytes += size;
+}
+
+static struct JsonAllocationCounter
+{
+	JsonAllocationCounter()
+	{
+		chromecast::JsonHeapAllocator::SetAllocationHook(&CountJsonAllocation);
+	}
+} g_json_allocation_counter;
+
+void* operator new(size_t size)
+{
+	++g_allocations;
+	g_allocated_bytes += size;
+	void* memory = malloc(size != 0 ? size : 1);
+	if (!memory)
+		throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* memory) throw()
+{
+	free(memory);
+}
+
+void operator delete[](void* memory) throw()
+{
+	free(memory);
+}
+
+namespace chromecast
+{
+	//never inlined, the whole program optimization of the release builds would otherwise see the bytes are only folded.
+	__declspec(noinline) void EscapeBytes(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		unsigned char folded = 0;
+		for (size_t index = 0; index < size; ++index)
+			folded ^= bytes[index];
+		g_escaped_bytes.fetch_xor(folded, std::memory_order_relaxed);
+	}
+
+	AllocationStatistics GetAllocationStatistics()
+	{
+		AllocationStatistics statistics;
+		statistics.allocations = g_allocations;
+		statistics.allocated_bytes = g_allocated_bytes;
+		return statistics;
+	}
+}
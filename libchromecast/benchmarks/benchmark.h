@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <boost\chrono.hpp>
+
+namespace chromecast
+{
+	struct AllocationStatistics
+	{
+		uint64_t allocations = 0;
+		uint64_t allocated_bytes = 0;
+	};
+
+	//counts the allocations made through operator new and the mallocs of the json code, implemented by allocation_counter.cpp
+	//which replaces the global operator new and hooks JsonHeapAllocator. a json arena chunk is only counted when it is not reused.
+	AllocationStatistics GetAllocationStatistics();
+
+	struct BenchmarkResult
+	{
+		std::string name;
+		uint64_t iterations = 0;
+		double nanoseconds_per_operation = 0;
+		double allocations_per_operation = 0;
+		double bytes_per_operation = 0;
+	};
+
+	//reads the bytes in a function the optimizer cannot see into, implemented by allocation_counter.cpp.
+	void EscapeBytes(const void* data, size_t size);
+
+	//keeps the compiler from dropping a computation whose result is otherwise unused.
+	template <typename T>
+	inline void KeepResult(const T& value)
+	{
+		EscapeBytes(&value, sizeof(value));
+	}
+
+	//runs the operation in batches of growing size until a batch takes at least the minimal duration, the last batch is reported.
+	//boost chrono is used since the steady clock of the vc12 runtime only ticks every few milliseconds.
+	template <typename TOperation>
+	BenchmarkResult RunBenchmark(const std::string& name, const TOperation& operation, uint32_t minimal_duration_milliseconds = 500)
+	{
+		typedef boost::chrono::steady_clock clock;
+		const boost::chrono::nanoseconds minimal_duration = boost::chrono::milliseconds(minimal_duration_milliseconds);
+
+		operation();
+		uint64_t iterations = 1;
+		for (;;)
+		{
+			AllocationStatistics allocations_before = GetAllocationStatistics();
+			clock::time_point start = clock::now();
+			for (uint64_t iteration = 0; iteration < iterations; ++iteration)
+				operation();
+			boost::chrono::nanoseconds elapsed = clock::now() - start;
+			AllocationStatistics allocations_after = GetAllocationStatistics();
+
+			if (elapsed >= minimal_duration)
+			{
+				BenchmarkResult result;
+				result.name = name;
+				result.iterations = iterations;
+				result.nanoseconds_per_operation = static_cast<double>(elapsed.count()) / iterations;
+				result.allocations_per_operation = static_cast<double>(allocations_after.allocations - allocations_before.allocations) / iterations;
+				result.bytes_per_operation = static_cast<double>(allocations_after.allocated_bytes - allocations_before.allocated_bytes) / iterations;
+				return result;
+			}
+
+			//aims slightly above the minimal duration, growing by at most a factor of 100 per batch.
+			double scale = elapsed.count() > 0 ? 1.2 * minimal_duration.count() / elapsed.count() : 100;
+			iterations = static_cast<uint64_t>(iterations * (std::min)((std::max)(scale, 2.0), 100.0));
+		}
+	}
+
+	inline void PrintBenchmarkHeader(std::ostream& stream)
+	{
+		stream << std::left << std::setw(48) << "benchmark" << std::right
+			<< std::setw(14) << "iterations"
+			<< std::setw(14) << "ns/op"
+			<< std::setw(14) << "allocs/op"
+			<< std::setw(14) << "bytes/op" << std::endl;
+	}
+
+	inline void PrintBenchmarkResult(std::ostream& stream, const BenchmarkResult& result)
+	{
+		stream << std::left << std::setw(48) << result.name << std::right << std::fixed
+			<< std::setw(14) << result.iterations
+			<< std::setw(14) << std::setprecision(1) << result.nanoseconds_per_operation
+			<< std::setw(14) << std::setprecision(2) << result.allocations_per_operation
+			<< std::setw(14) << std::setprecision(1) << result.bytes_per_operation << std::endl;
+	}
+}
@@ -0,0 +1,263 @@
+// codec_benchmark.cpp : measures the message codec and the status parsers on captured payloads.
+//
+
+#include "benchmark.h"
+#include "../libchromecast/cast_message.h"
+#include "../libchromecast/json_message.h"
+#include "../libchromecast/json_writer.h"
+#include "../libchromecast/media_messages.h"
+#include "../libchromecast/receiver_messages.h"
+
+#include <iostream>
+#include <functional>
+#include <boost/lexical_cast.hpp>
+
+using namespace chromecast;
+
+static const std::string k_ping_payload = R"({"type":"PING"})";
+
+static const std::string k_receiver_status_payload = R"({"requestId":0,"status":{"applications":[{"appId":"CC1AD845","displayName":"Default Media Receiver",)"
+	R"("namespaces":[{"name":"urn:x-cast:com.google.cast.player.message"},{"name":"urn:x-cast:com.google.cast.media"}],)"
+	R"("sessionId":"7E2FF513-CDF6-9A91-2B28-3E3DE7BAC174","statusText":"Ready To Cast","transportId":"web-5"}],)"
+	R"("isActiveInput":true,"isStandBy":false,"volume":{"level":0.6,"muted":false}},"type":"RECEIVER_STATUS"})";
+
+static std::string BuildTrack(uint32_t id, const std::string& language)
+{
+	std::string track_id = boost::lexical_cast<std::string>(id);
+	return R"({"trackId":)" + track_id + R"(,"type":"TEXT","trackContentId":"https://commondatastorage.googleapis.com/gtv-videos-bucket/CastVideos/tracks/)" + language + R"(.vtt",)"
+		R"("trackContentType":"text/vtt","name":")" + language + R"( subtitles","language":")" + language + R"(","subtype":"SUBTITLES"})";
+}
+
+static std::string BuildMedia(uint32_t index)
+{
+	std::string suffix = boost::lexical_cast<std::string>(index);
+	std::string tracks = BuildTrack(1, "en-US") + "," + BuildTrack(2, "fr-FR") + "," + BuildTrack(3, "de-DE") + "," + BuildTrack(4, "es-ES");
+	return R"({"contentId":"http://commondatastorage.googleapis.com/gtv-videos-bucket/big_buck_bunny_)" + suffix + R"(.mp4","contentType":"video/mp4","streamType":"BUFFERED","duration":596.474195,)"
+		R"("metadata":{"type":0,"metadataType":0,"title":"Big Buck Bunny )" + suffix + R"(","images":[{"url":"http://commondatastorage.googleapis.com/gtv-videos-bucket/sample/images/BigBuckBunny.jpg"}]},)"
+		R"("tracks":[)" + tracks + "]}";
+}
+
+//a media status of the default media receiver playing a queue of ten items, each with four subtitle tracks.
+static std::string BuildMediaStatusPayload()
+{
+	std::string items;
+	for (uint32_t index = 1; index <= 10; ++index)
+	{
+		if (index != 1)
+			items += ",";
+		items += R"({"itemId":)" + boost::lexical_cast<std::string>(index) + R"(,"autoplay":true,"startTime":0,"activeTrackIds":[1],"media":)" + BuildMedia(index) + "}";
+	}
+
+	return R"({"type":"MEDIA_STATUS","requestId":0,"status":[{"mediaSessionId":1,"playbackRate":1,"playerState":"PLAYING","currentTime":12.416,)"
+		R"("supportedMediaCommands":15,"volume":{"level":1,"muted":false},"currentItemId":1,"repeatMode":"REPEAT_OFF","activeTrackIds":[1],)"
+		R"("media":)" + BuildMedia(1) + R"(,"items":[)" + items + "]}]}";
+}
+
+static CastMessage BuildCastMessage(const std::string& source, const std::string& destination, const std::string& name_space, const std::string& payload)
+{
+	CastMessage message;
+	message.address = CastMessage::Address(source, destination, name_space);
+	message.payload_type = CastMessage::ePayloadType::String;
+	message.payload_utf8 = payload;
+	return message;
+}
+
+static std::vector<byte> Encode(const CastMessage& message)
+{
+	std::vector<byte> encoded(message.GetEncodedSize());
+	message.Encode(encoded.data());
+	return encoded;
+}
+
+static Media BuildLoadMedia()
+{
+	Media media;
+	media.content_id = "http://commondatastorage.googleapis.com/gtv-videos-bucket/big_buck_bunny_1080p.mp4";
+	media.content_type = "video/mp4";
+	media.stream_type = Media::eStreamType::BUFFERED;
+	media.meta_data.title = "Big Buck Bunny";
+	media.meta_data.images.emplace_back("http://commondatastorage.googleapis.com/gtv-videos-bucket/sample/images/BigBuckBunny.jpg");
+	for (uint32_t id = 1; id <= 4; ++id)
+	{
+		Media::Track track;
+		track.id = id;
+		track.type = Media::Track::eTrackType::Text;
+		track.content_id = "https://commondatastorage.googleapis.com/gtv-videos-bucket/CastVideos/tracks/track" + boost::lexical_cast<std::string>(id) + ".vtt";
+		track.content_type = "text/vtt";
+		track.name = "subtitles";
+		track.language = "en-US";
+		track.sub_type = "SUBTITLES";
+		media.tracks.push_back(track);
+	}
+	return media;
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		uint32_t minimal_duration_milliseconds = argc > 1 ? boost::lexical_cast<uint32_t>(argv[1]) : 500;
+
+		const std::string media_status_payload = BuildMediaStatusPayload();
+		const CastMessage ping = BuildCastMessage("sender-0", "receiver-0", "urn:x-cast:com.google.cast.tp.heartbeat", k_ping_payload);
+		const CastMessage media_status = BuildCastMessage("web-5", "*", "urn:x-cast:com.google.cast.media", media_status_payload);
+		const std::vector<byte> encoded_ping = Encode(ping);
+		const std::vector<byte> encoded_media_status = Encode(media_status);
+		const Media load_media = BuildLoadMedia();
+
+		JsonMessage parsed_receiver_status;
+		parsed_receiver_status.Parse(k_receiver_status_payload);
+		JsonMessage parsed_media_status;
+		parsed_media_status.Parse(media_status_payload);
+
+		std::cout << "PING payload: " << k_ping_payload.size() << " bytes, encoded " << encoded_ping.size() << " bytes" << std::endl;
+		std::cout << "RECEIVER_STATUS payload: " << k_receiver_status_payload.size() << " bytes" << std::endl;
+		std::cout << "MEDIA_STATUS payload: " << media_status_payload.size() << " bytes, encoded " << encoded_media_status.size() << " bytes" << std::endl;
+		std::cout << std::endl;
+
+		std::vector<BenchmarkResult> results;
+		auto run = [&](const std::string& name, const std::function<void()>& operation)
+		{
+			results.push_back(RunBenchmark(name, operation, minimal_duration_milliseconds));
+			PrintBenchmarkResult(std::cout, results.back());
+		};
+
+		PrintBenchmarkHeader(std::cout);
+
+		std::vector<byte> encode_buffer(encoded_media_status.size());
+		run("CastMessage::Encode PING", [&]()
+		{
+			KeepResult(ping.Encode(encode_buffer.data() + encode_buffer.size() - ping.GetEncodedSize()));
+		});
+		run("CastMessage::Encode MEDIA_STATUS", [&]()
+		{
+			KeepResult(media_status.Encode(encode_buffer.data() + encode_buffer.size() - media_status.GetEncodedSize()));
+		});
+		run("CastMessageView::Parse PING", [&]()
+		{
+			CastMessageView view;
+			KeepResult(view.Parse(encoded_ping.data(), encoded_ping.size()));
+		});
+		run("CastMessageView::Parse MEDIA_STATUS", [&]()
+		{
+			CastMessageView view;
+			KeepResult(view.Parse(encoded_media_status.data(), encoded_media_status.size()));
+		});
+		run("CastMessageView::ToMessage MEDIA_STATUS", [&]()
+		{
+			CastMessageView view;
+			view.Parse(encoded_media_status.data(), encoded_media_status.size());
+			CastMessage message = view.ToMessage();
+			KeepResult(message);
+		});
+
+		run("JsonMessage::Parse PING", [&]()
+		{
+			JsonMessage message;
+			message.Parse(boost::string_ref(k_ping_payload));
+			KeepResult(message);
+		});
+		run("JsonMessage::Parse RECEIVER_STATUS", [&]()
+		{
+			JsonMessage message;
+			message.Parse(boost::string_ref(k_receiver_status_payload));
+			KeepResult(message);
+		});
+		run("JsonMessage::Parse MEDIA_STATUS", [&]()
+		{
+			JsonMessage message;
+			message.Parse(boost::string_ref(media_status_payload));
+			KeepResult(message);
+		});
+		//includes restoring the text that the previous iteration parsed over.
+		std::vector<char> insitu_buffer(media_status_payload.begin(), media_status_payload.end());
+		run("JsonMessage::ParseInsitu MEDIA_STATUS", [&]()
+		{
+			std::copy(media_status_payload.begin(), media_status_payload.end(), insitu_buffer.begin());
+			JsonMessage message;
+			message.ParseInsitu(insitu_buffer.data(), insitu_buffer.size());
+			KeepResult(message);
+		});
+		run("JsonMessage::ToString MEDIA_STATUS", [&]()
+		{
+			std::string text = parsed_media_status.ToString();
+			KeepResult(text);
+		});
+		run("JsonMessagePart::operator[] build PING", [&]()
+		{
+			JsonMessage message;
+			message["type"] = "PING";
+			std::string text = message.ToString();
+			KeepResult(text);
+		});
+		run("JsonMessagePart::operator[] build LOAD", [&]()
+		{
+			JsonMessage message;
+			message["type"] = "LOAD";
+			JsonMessagePart media = message["media"];
+			load_media.ToMessage(media);
+			message["autoplay"] = true;
+			message["requestId"] = static_cast<uint64_t>(42);
+			std::string text = message.ToString();
+			KeepResult(text);
+		});
+		run("JsonWriter build LOAD", [&]()
+		{
+			JsonWriter message;
+			message.StartObject();
+			message.Member("type", "LOAD");
+			message.Key("media");
+			load_media.ToMessage(message);
+			message.Member("autoplay", true);
+			message.Member("requestId", static_cast<uint64_t>(42));
+			message.EndObject();
+			std::string text = message.ToString();
+			KeepResult(text);
+		});
+
+		run("ReceiverStatus::FromMessage", [&]()
+		{
+			ReceiverStatus status = ReceiverStatus::FromMessage(parsed_receiver_status);
+			KeepResult(status);
+		});
+		run("MediaStatus::FromMessage", [&]()
+		{
+			MediaStatus status = MediaStatus::FromMessage(parsed_media_status);
+			KeepResult(status);
+		});
+		run("MediaResponse::FromMessage", [&]()
+		{
+			MediaResponse response = MediaResponse::FromMessage(parsed_media_status);
+			KeepResult(response);
+		});
+		run("Parse + ReceiverStatus::FromMessage", [&]()
+		{
+			JsonMessage message;
+			message.Parse(boost::string_ref(k_receiver_status_payload));
+			ReceiverStatus status = ReceiverStatus::FromMessage(message);
+			KeepResult(status);
+		});
+		run("Parse + MediaStatus::FromMessage", [&]()
+		{
+			JsonMessage message;
+			message.Parse(boost::string_ref(media_status_payload));
+			MediaStatus status = MediaStatus::FromMessage(message);
+			KeepResult(status);
+		});
+		run("ReceiverStatus::FromJson", [&]()
+		{
+			ReceiverStatus status = ReceiverStatus::FromJson(k_receiver_status_payload);
+			KeepResult(status);
+		});
+		run("MediaStatus::FromJson", [&]()
+		{
+			MediaStatus status = MediaStatus::FromJson(media_status_payload);
+			KeepResult(status);
+		});
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Error:\n" << e.what() << "\n";
+		return 1;
+	}
+}
@@ -0,0 +1,546 @@
+// loopback_benchmark.cpp : drives many clients against the mock receiver on the loopback interface.
+//
+
+#include "benchmark.h"
+#include "../mock-receiver/mock_receiver.h"
+#include "../libchromecast/client.h"
+#include "../libchromecast/default_media_player.h"
+
+#include <map>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <iostream>
+#include <condition_variable>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+
+using namespace chromecast;
+
+typedef boost::chrono::steady_clock benchmark_clock;
+
+static std::atomic<uint64_t> g_inbound_messages(0);
+
+//counts every message dispatched to a channel, the payload is then handled as usual by the typed OnMessage overloads.
+template <typename TChannel>
+struct CountingChannel : public TChannel
+{
+	template <typename... TArgs>
+	CountingChannel(TArgs&&... args)
+		: TChannel(std::forward<TArgs>(args)...)
+	{
+	}
+
+	void OnMessage(const CastMessageView& message) override
+	{
+		++g_inbound_messages;
+		ChromecastChannel::OnMessage(message);
+	}
+};
+
+typedef ChromecastClient<ChromecastConnection, CountingChannel<ReceiverChannel>, CountingChannel<ConnectionChannel>, CountingChannel<HeartbeatChannel>> BenchmarkClient;
+typedef DefaultMediaPlayer<CountingChannel<MediaChannel>> BenchmarkMediaPlayer;
+
+class CountdownLatch
+{
+	std::mutex _mutex;
+	std::condition_variable _condition;
+	size_t _count;
+public:
+	explicit CountdownLatch(size_t count)
+		: _count(count)
+	{
+	}
+
+	void CountDown()
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (_count != 0 && --_count == 0)
+			_condition.notify_all();
+	}
+
+	bool Wait(uint32_t timeout_seconds)
+	{
+		std::unique_lock<std::mutex> lock(_mutex);
+		return _condition.wait_for(lock, std::chrono::seconds(timeout_seconds), [=]() { return _count == 0; });
+	}
+};
+
+//runs an io_service on a set of threads, exceptions thrown by handlers are counted instead of ending the thread.
+class ThreadPool
+{
+	boost::asio::io_service& _io_service;
+	std::unique_ptr<boost::asio::io_service::work> _work;
+	std::vector<std::thread> _threads;
+	std::atomic<uint64_t> _errors;
+public:
+	ThreadPool(boost::asio::io_service& io_service, size_t thread_count)
+		: _io_service(io_service),
+		_work(new boost::asio::io_service::work(io_service)),
+		_errors(0)
+	{
+		for (size_t index = 0; index < thread_count; ++index)
+		{
+			_threads.emplace_back([this]()
+			{
+				for (;;)
+				{
+					try
+					{
+						_io_service.run();
+						return;
+					}
+					catch (std::exception&)
+					{
+						++_errors;
+					}
+				}
+			});
+		}
+	}
+
+	~ThreadPool()
+	{
+		_work.reset();
+		_io_service.stop();
+		for (auto& thread : _threads)
+			thread.join();
+	}
+
+	uint64_t GetErrorCount() const
+	{
+		return _errors;
+	}
+};
+
+struct BenchmarkOptions
+{
+	std::vector<size_t> connection_counts = { 1, 10, 100 };
+	std::vector<size_t> thread_counts = { 1, 2, 4 };
+	size_t receiver_threads = 2;
+	size_t requests_in_flight = 1;
+	uint32_t seconds = 5;
+	uint32_t response_latency_milliseconds = 0;
+	uint32_t broadcasts_per_second = 100;
+	uint32_t timeout_seconds = 30;
+};
+
+struct SweepResult
+{
+	size_t connections = 0;
+	size_t threads = 0;
+	double connect_wall_milliseconds = 0;
+	double connect_p50_milliseconds = 0;
+	double connect_p99_milliseconds = 0;
+	double round_trip_p50_microseconds = 0;
+	double round_trip_p99_microseconds = 0;
+	double round_trip_p999_microseconds = 0;
+	double requests_per_second = 0;
+	double inbound_messages_per_second = 0;
+	uint64_t handler_errors = 0;
+	bool completed = true;
+};
+
+//every client keeps its latencies to itself, they are only touched on the strand of its connection.
+struct ClientState
+{
+	std::shared_ptr<BenchmarkClient> client;
+	std::shared_ptr<BenchmarkMediaPlayer> media_player;
+	std::vector<uint32_t> round_trip_microseconds;
+};
+
+static double Percentile(const std::vector<uint32_t>& sorted_values, double fraction)
+{
+	if (sorted_values.empty())
+		return 0;
+	size_t index = (std::min)(sorted_values.size() - 1, static_cast<size_t>(fraction * sorted_values.size()));
+	return sorted_values[index];
+}
+
+static uint32_t MicrosecondsSince(benchmark_clock::time_point start)
+{
+	return static_cast<uint32_t>(boost::chrono::duration_cast<boost::chrono::microseconds>(benchmark_clock::now() - start).count());
+}
+
+static void RequestStatus(std::shared_ptr<ClientState> state, benchmark_clock::time_point deadline, std::shared_ptr<CountdownLatch> latch)
+{
+	benchmark_clock::time_point start = benchmark_clock::now();
+	state->client->GetStatus([=](const ReceiverStatus& status)
+	{
+		state->round_trip_microseconds.push_back(MicrosecondsSince(start));
+		if (benchmark_clock::now() < deadline)
+			RequestStatus(state, deadline, latch);
+		else
+			latch->CountDown();
+	});
+}
+
+static SweepResult RunSweep(const BenchmarkOptions& options, size_t connection_count, size_t thread_count)
+{
+	SweepResult result;
+	result.connections = connection_count;
+	result.threads = thread_count;
+
+	boost::asio::io_service receiver_io_service;
+	MockReceiver::Options receiver_options;
+	receiver_options.port = 0;
+	receiver_options.response_latency_milliseconds = options.response_latency_milliseconds;
+	receiver_options.media_status_broadcasts_per_second = options.broadcasts_per_second;
+	MockReceiver receiver(receiver_io_service, receiver_options);
+	receiver.Start();
+	uint16_t port = receiver.GetPort();
+	ThreadPool receiver_threads(receiver_io_service, options.receiver_threads);
+
+	boost::asio::io_service client_io_service;
+	std::vector<std::shared_ptr<ClientState>> states;
+	for (size_t index = 0; index < connection_count; ++index)
+	{
+		auto state = std::make_shared<ClientState>();
+		state->client = std::make_shared<BenchmarkClient>(client_io_service);
+		states.push_back(state);
+	}
+
+	//written by handlers on the client threads, which may still run after a wait timed out.
+	//declared before the pool so they outlive its threads.
+	std::mutex connect_mutex;
+	std::vector<uint32_t> connect_microseconds;
+	std::mutex round_trips_mutex;
+	std::vector<uint32_t> round_trips;
+
+	{
+		ThreadPool client_threads(client_io_service, thread_count);
+
+		//connect and handshake.
+		auto connected_latch = std::make_shared<CountdownLatch>(connection_count);
+		benchmark_clock::time_point connect_start = benchmark_clock::now();
+		for (auto& state : states)
+		{
+			auto client = state->client;
+			client->GetStrand().post([&, client, connected_latch]()
+			{
+				benchmark_clock::time_point start = benchmark_clock::now();
+				client->AsyncConnect("127.0.0.1", [&, start, connected_latch](bool connected)
+				{
+					{
+						std::lock_guard<std::mutex> lock(connect_mutex);
+						if (connected)
+							connect_microseconds.push_back(MicrosecondsSince(start));
+					}
+					connected_latch->CountDown();
+				}, port);
+			});
+		}
+		result.completed = connected_latch->Wait(options.timeout_seconds);
+		result.connect_wall_milliseconds = MicrosecondsSince(connect_start) / 1000.0;
+		{
+			std::lock_guard<std::mutex> lock(connect_mutex);
+			std::sort(connect_microseconds.begin(), connect_microseconds.end());
+			result.connect_p50_milliseconds = Percentile(connect_microseconds, 0.5) / 1000;
+			result.connect_p99_milliseconds = Percentile(connect_microseconds, 0.99) / 1000;
+			result.completed &= connect_microseconds.size() == connection_count;
+		}
+
+		//closed loop GET_STATUS round trips through RequestChannel::Request.
+		if (result.completed)
+		{
+			auto requests_latch = std::make_shared<CountdownLatch>(connection_count * options.requests_in_flight);
+			benchmark_clock::time_point requests_start = benchmark_clock::now();
+			benchmark_clock::time_point deadline = requests_start + boost::chrono::seconds(options.seconds);
+			for (auto& state : states)
+			{
+				state->client->GetStrand().post([=]()
+				{
+					for (size_t index = 0; index < options.requests_in_flight; ++index)
+						RequestStatus(state, deadline, requests_latch);
+				});
+			}
+			result.completed = requests_latch->Wait(options.seconds + options.timeout_seconds);
+			double elapsed_seconds = MicrosecondsSince(requests_start) / 1000000.0;
+
+			for (auto& state : states)
+			{
+				//the strand of the client may still be completing a late response.
+				auto latch = std::make_shared<CountdownLatch>(1);
+				state->client->GetStrand().post([&, state, latch]()
+				{
+					{
+						std::lock_guard<std::mutex> lock(round_trips_mutex);
+						round_trips.insert(round_trips.end(), state->round_trip_microseconds.begin(), state->round_trip_microseconds.end());
+					}
+					latch->CountDown();
+				});
+				latch->Wait(options.timeout_seconds);
+			}
+			std::lock_guard<std::mutex> lock(round_trips_mutex);
+			std::sort(round_trips.begin(), round_trips.end());
+			result.round_trip_p50_microseconds = Percentile(round_trips, 0.5);
+			result.round_trip_p99_microseconds = Percentile(round_trips, 0.99);
+			result.round_trip_p999_microseconds = Percentile(round_trips, 0.999);
+			result.requests_per_second = round_trips.size() / elapsed_seconds;
+		}
+
+		//MEDIA_STATUS broadcasts of a playing media session.
+		if (result.completed && options.broadcasts_per_second != 0)
+		{
+			auto loaded_latch = std::make_shared<CountdownLatch>(connection_count);
+			for (auto& state : states)
+			{
+				state->client->GetStrand().post([=]()
+				{
+					state->media_player = std::make_shared<BenchmarkMediaPlayer>();
+					state->client->Launch(state->media_player, [=](bool launched)
+					{
+						if (!launched)
+							return loaded_latch->CountDown();
+
+						Media media;
+						media.content_id = "http://commondatastorage.googleapis.com/gtv-videos-bucket/big_buck_bunny_1080p.mp4";
+						media.content_type = "video/mp4";
+						media.stream_type = Media::eStreamType::BUFFERED;
+						state->media_player->Load(media, true, [=](const MediaResponse& response)
+						{
+							loaded_latch->CountDown();
+						});
+					});
+				});
+			}
+			result.completed = loaded_latch->Wait(options.timeout_seconds);
+
+			uint64_t inbound_before = g_inbound_messages;
+			benchmark_clock::time_point broadcast_start = benchmark_clock::now();
+			std::this_thread::sleep_for(std::chrono::seconds(options.seconds));
+			result.inbound_messages_per_second = (g_inbound_messages - inbound_before) / (MicrosecondsSince(broadcast_start) / 1000000.0);
+		}
+
+		//the pool stops the io_service when it goes out of scope, which would drop close handlers that did not run yet.
+		auto closed_latch = std::make_shared<CountdownLatch>(connection_count);
+		for (auto& state : states)
+		{
+			auto client = state->client;
+			client->GetStrand().post([client, closed_latch]()
+			{
+				client->Close();
+				closed_latch->CountDown();
+			});
+		}
+		result.completed &= closed_latch->Wait(options.timeout_seconds);
+		result.handler_errors = client_threads.GetErrorCount();
+	}
+
+	//the client threads are joined, nothing refers to the clients anymore.
+	states.clear();
+	receiver.Stop();
+	return result;
+}
+
+static std::atomic<bool> g_blocking_handler_running(false);
+static std::atomic<uint64_t> g_blocking_handler_calls(0);
+
+//listens on the receiver namespace next to the receiver channel and holds the handler executor for a while on every message.
+struct BlockingChannel : public ChromecastChannel
+{
+	std::shared_ptr<CountdownLatch> entered;
+	std::vector<uint32_t> handled_sizes;
+
+	BlockingChannel(ChromecastConnection& connection, std::shared_ptr<CountdownLatch> entered)
+		: ChromecastChannel(connection, ChromecastChannel::Address("sender-0", "receiver-0", "urn:x-cast:com.google.cast.receiver")),
+		entered(entered)
+	{
+	}
+
+	void OnMessage(const CastMessageView& message) override
+	{
+		g_blocking_handler_running = true;
+		++g_blocking_handler_calls;
+		entered->CountDown();
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		//touches a member of the derived channel after the owner started destroying it.
+		handled_sizes.push_back(static_cast<uint32_t>(message.payload_utf8.size()));
+		g_blocking_handler_running = false;
+	}
+};
+
+struct LifetimeCheckClient : public BenchmarkClient
+{
+	LifetimeCheckClient(boost::asio::io_service& io_service)
+		: BenchmarkClient(io_service)
+	{
+	}
+
+	ChromecastConnection& GetConnection()
+	{
+		return _connection;
+	}
+};
+
+//destroys a channel while the handler executor is inside its handler, the destruction has to wait for the handler
+//and the channel must not see a message after it was destroyed.
+static bool CheckDestroyWhileHandling(const BenchmarkOptions& options)
+{
+	boost::asio::io_service receiver_io_service;
+	MockReceiver::Options receiver_options;
+	receiver_options.port = 0;
+	MockReceiver receiver(receiver_io_service, receiver_options);
+	receiver.Start();
+	uint16_t port = receiver.GetPort();
+	ThreadPool receiver_threads(receiver_io_service, 1);
+
+	boost::asio::io_service client_io_service;
+	boost::asio::io_service executor;
+	LifetimeCheckClient client(client_io_service);
+	client.SetHandlerExecutor(&executor);
+
+	bool passed = false;
+	{
+		ThreadPool client_threads(client_io_service, 1);
+		ThreadPool executor_threads(executor, 1);
+
+		auto connected_latch = std::make_shared<CountdownLatch>(1);
+		auto connected = std::make_shared<std::atomic<bool>>(false);
+		client.GetStrand().post([&client, port, connected_latch, connected]()
+		{
+			client.AsyncConnect("127.0.0.1", [=](bool succeeded)
+			{
+				*connected = succeeded;
+				connected_latch->CountDown();
+			}, port);
+		});
+
+		if (connected_latch->Wait(options.timeout_seconds) && *connected)
+		{
+			auto entered = std::make_shared<CountdownLatch>(1);
+			auto channel = client.GetConnection().channel_factory.CreateChannel<BlockingChannel>(entered);
+			client.GetStrand().post([&client]()
+			{
+				client.GetStatus(nullptr);
+			});
+
+			if (entered->Wait(options.timeout_seconds))
+			{
+				channel.reset();
+				bool waited_for_handler = !g_blocking_handler_running;
+				uint64_t calls = g_blocking_handler_calls;
+
+				//the answer of a second request reaches the receiver channel, but not the destroyed channel.
+				auto answered = std::make_shared<CountdownLatch>(1);
+				client.GetStrand().post([&client, answered]()
+				{
+					client.GetStatus([=](const ReceiverStatus& status)
+					{
+						answered->CountDown();
+					});
+				});
+				passed = answered->Wait(options.timeout_seconds) && waited_for_handler && g_blocking_handler_calls == calls;
+			}
+		}
+
+		auto closed_latch = std::make_shared<CountdownLatch>(1);
+		client.GetStrand().post([&client, closed_latch]()
+		{
+			client.Close();
+			closed_latch->CountDown();
+		});
+		closed_latch->Wait(options.timeout_seconds);
+		passed &= client_threads.GetErrorCount() == 0 && executor_threads.GetErrorCount() == 0;
+	}
+
+	receiver.Stop();
+	return passed;
+}
+
+static std::vector<size_t> ParseList(const std::string& value)
+{
+	std::vector<std::string> items;
+	boost::split(items, value, boost::is_any_of(","));
+	std::vector<size_t> values;
+	for (auto& item : items)
+		values.push_back(boost::lexical_cast<size_t>(item));
+	return values;
+}
+
+static BenchmarkOptions ParseOptions(int argc, char* argv[])
+{
+	BenchmarkOptions options;
+	for (int index = 1; index < argc; ++index)
+	{
+		std::string argument = argv[index];
+		size_t separator = argument.find('=');
+		THROW_ON_ERROR_EX(separator == std::string::npos, "expected name=value instead of " + argument);
+		std::string name = argument.substr(0, separator);
+		std::string value = argument.substr(separator + 1);
+
+		if (name == "connections")
+			options.connection_counts = ParseList(value);
+		else if (name == "threads")
+			options.thread_counts = ParseList(value);
+		else if (name == "receiver_threads")
+			options.receiver_threads = boost::lexical_cast<size_t>(value);
+		else if (name == "in_flight")
+			options.requests_in_flight = boost::lexical_cast<size_t>(value);
+		else if (name == "seconds")
+			options.seconds = boost::lexical_cast<uint32_t>(value);
+		else if (name == "latency_ms")
+			options.response_latency_milliseconds = boost::lexical_cast<uint32_t>(value);
+		else if (name == "broadcast_rate")
+			options.broadcasts_per_second = boost::lexical_cast<uint32_t>(value);
+		else if (name == "timeout")
+			options.timeout_seconds = boost::lexical_cast<uint32_t>(value);
+		else
+			THROW_ON_ERROR_EX(true, "unknown option " + name);
+	}
+	return options;
+}
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		BenchmarkOptions options = ParseOptions(argc, argv);
+
+		if (!CheckDestroyWhileHandling(options))
+		{
+			std::cerr << "a channel destroyed while its handler was running was not detached first" << std::endl;
+			return 1;
+		}
+		std::cout << "destroying a channel while its handler runs: ok" << std::endl;
+
+		std::cout << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(8) << "conns"
+			<< std::setw(8) << "threads"
+			<< std::setw(12) << "connect ms"
+			<< std::setw(10) << "p50 ms"
+			<< std::setw(10) << "p99 ms"
+			<< std::setw(10) << "rtt p50"
+			<< std::setw(10) << "rtt p99"
+			<< std::setw(10) << "rtt p999"
+			<< std::setw(12) << "req/s"
+			<< std::setw(12) << "inbound/s"
+			<< std::setw(8) << "errors" << std::endl;
+
+		for (size_t connection_count : options.connection_counts)
+		{
+			for (size_t thread_count : options.thread_counts)
+			{
+				SweepResult result = RunSweep(options, connection_count, thread_count);
+				std::cout << std::setw(8) << result.connections
+					<< std::setw(8) << result.threads
+					<< std::setw(12) << result.connect_wall_milliseconds
+					<< std::setw(10) << result.connect_p50_milliseconds
+					<< std::setw(10) << result.connect_p99_milliseconds
+					<< std::setw(10) << result.round_trip_p50_microseconds
+					<< std::setw(10) << result.round_trip_p99_microseconds
+					<< std::setw(10) << result.round_trip_p999_microseconds
+					<< std::setw(12) << result.requests_per_second
+					<< std::setw(12) << result.inbound_messages_per_second
+					<< std::setw(8) << result.handler_errors
+					<< (result.completed ? "" : "  (timed out)") << std::endl;
+			}
+		}
+		std::cout << "round trip times are in microseconds." << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Error:\n" << e.what() << "\n";
+		return 1;
+	}
+}
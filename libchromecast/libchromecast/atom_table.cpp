@@ -0,0 +1,169 @@
+#include "atom_table.h"
+#include "utils.h"
+
+#include <boost\functional\hash.hpp>
+
+namespace chromecast
+{
+	using namespace std;
+
+	//never destroyed, an address in a static object may still release its atoms while the process exits.
+	static AtomTable* s_default_table = nullptr;
+	static once_flag s_default_table_flag;
+
+	size_t AtomTable::StringHash::operator()(const boost::string_ref& value) const
+	{
+		return boost::hash_range(value.begin(), value.end());
+	}
+
+	AtomTable::Entry::Entry()
+		: references(0),
+		interned(false)
+	{
+	}
+
+	AtomTable::AtomTable()
+		: _atom_count(1)
+	{
+		for (auto& chunk : _chunks)
+			chunk = nullptr;
+		//the empty string of k_no_atom.
+		_chunks[0] = new Entry[k_chunk_size];
+	}
+
+	AtomTable::~AtomTable()
+	{
+		for (auto& chunk : _chunks)
+			delete[] chunk.load();
+	}
+
+	AtomTable& AtomTable::GetDefault()
+	{
+		call_once(s_default_table_flag, []()
+		{
+			s_default_table = new AtomTable();
+		});
+		return *s_default_table;
+	}
+
+	AtomTable::Entry& AtomTable::GetEntry(Atom atom) const
+	{
+		return _chunks[atom / k_chunk_size].load(memory_order_acquire)[atom % k_chunk_size];
+	}
+
+	Atom AtomTable::Intern(const boost::string_ref& value)
+	{
+		lock_guard<mutex> lock(_mutex);
+		auto it = _string_to_atom.find(value);
+		if (it != _string_to_atom.end())
+		{
+			GetEntry(it->second).references.fetch_add(1, memory_order_relaxed);
+			return it->second;
+		}
+
+		Atom atom;
+		if (!_free_atoms.empty())
+		{
+			atom = _free_atoms.back();
+			_free_atoms.pop_back();
+		}
+		else
+		{
+			atom = _atom_count.load(memory_order_relaxed);
+			size_t chunk_index = atom / k_chunk_size;
+			THROW_ON_ERROR_EX(chunk_index >= k_max_chunk_count, "atom table is full");
+			if (!_chunks[chunk_index].load(memory_order_relaxed))
+				_chunks[chunk_index].store(new Entry[k_chunk_size], memory_order_release);
+		}
+
+		Entry& entry = GetEntry(atom);
+		entry.value.assign(value.begin(), value.end());
+		entry.references.store(1, memory_order_relaxed);
+		entry.interned = true;
+		_string_to_atom.emplace(boost::string_ref(entry.value), atom);
+		//publishes a new entry to ToString callers that did not take the lock, a reused one is published by handing out its atom.
+		if (atom == _atom_count.load(memory_order_relaxed))
+			_atom_count.store(atom + 1, memory_order_release);
+		return atom;
+	}
+
+	Atom AtomTable::Acquire(const boost::string_ref& value)
+	{
+		lock_guard<mutex> lock(_mutex);
+		auto it = _string_to_atom.find(value);
+		if (it == _string_to_atom.end())
+			return k_no_atom;
+
+		GetEntry(it->second).references.fetch_add(1, memory_order_relaxed);
+		return it->second;
+	}
+
+	void AtomTable::AddReference(Atom atom)
+	{
+		if (atom != k_no_atom)
+			GetEntry(atom).references.fetch_add(1, memory_order_relaxed);
+	}
+
+	void AtomTable::Release(Atom atom)
+	{
+		if (atom == k_no_atom)
+			return;
+
+		Entry& entry = GetEntry(atom);
+		if (entry.references.fetch_sub(1, memory_order_acq_rel) != 1)
+			return;
+
+		//Intern may have handed the atom out again before the lock was taken.
+		lock_guard<mutex> lock(_mutex);
+		if (!entry.interned || entry.references.load(memory_order_acquire) != 0)
+			return;
+
+		_string_to_atom.erase(boost::string_ref(entry.value));
+		entry.value.clear();
+		entry.interned = false;
+		_free_atoms.push_back(atom);
+	}
+
+	const std::string& AtomTable::ToString(Atom atom) const
+	{
+		THROW_ON_ERROR_EX(atom >= _atom_count.load(memory_order_acquire), "unknown atom");
+		return GetEntry(atom).value;
+	}
+
+	AtomCache::AtomCache(AtomTable& atom_table)
+		: _atom_table(atom_table)
+	{
+	}
+
+	AtomCache::~AtomCache()
+	{
+		Clear();
+	}
+
+	void AtomCache::Clear()
+	{
+		for (auto& string_to_atom : _string_to_atom)
+			_atom_table.Release(string_to_atom.second);
+		_string_to_atom.clear();
+	}
+
+	Atom AtomCache::Find(const boost::string_ref& value)
+	{
+		auto it = _string_to_atom.find(value);
+		if (it != _string_to_atom.end())
+			return it->second;
+
+		//a miss is not cached, a string the table does not know yet may still be interned later on.
+		Atom atom = _atom_table.Acquire(value);
+		if (atom != AtomTable::k_no_atom)
+			_string_to_atom.emplace(boost::string_ref(_atom_table.ToString(atom)), atom);
+		return atom;
+	}
+
+	void AtomCache::Trim()
+	{
+		//the ids of finished sessions would otherwise stay referenced for as long as the connection lives.
+		if (_string_to_atom.size() > k_max_atom_count)
+			Clear();
+	}
+}
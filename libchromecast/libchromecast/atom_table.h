@@ -0,0 +1,94 @@
+#pragma once
+#include "types.h"
+
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <boost\noncopyable.hpp>
+#include <boost\unordered_map.hpp>
+#include <boost\utility\string_ref.hpp>
+
+namespace chromecast
+{
+	//a small integer standing for an interned string, equal strings always get the same atom.
+	typedef uint32_t Atom;
+
+	//interns the ids and namespaces a process uses so they can be hashed and compared as integers.
+	//every atom returned by Intern or Acquire holds a reference, once the last one is released the string is dropped and its atom reused.
+	//the table grows with the strings in use at the same time, not with every transport id a process ever saw.
+	class AtomTable
+	{
+	public:
+		struct StringHash
+		{
+			size_t operator()(const boost::string_ref& value) const;
+		};
+
+		//never returned by Intern, returned by Find for a string that was not interned.
+		static const Atom k_no_atom = 0;
+		//the strings are stored in fixed size chunks that never move, so ToString does not need the lock.
+		static const size_t k_chunk_size = 256;
+		static const size_t k_max_chunk_count = 1024;
+	private:
+		struct Entry
+		{
+			std::string value;
+			std::atomic<uint32_t> references;
+			//false once the entry was released, a second release racing for the same entry must not free it again.
+			bool interned;
+
+			Entry();
+		};
+
+		boost::noncopyable _non_copyable;
+
+		std::mutex _mutex;
+		std::atomic<Entry*> _chunks[k_max_chunk_count];
+		std::atomic<Atom> _atom_count;
+		std::vector<Atom> _free_atoms;
+		//the keys point into the chunks.
+		boost::unordered_map<boost::string_ref, Atom, StringHash> _string_to_atom;
+
+		Entry& GetEntry(Atom atom) const;
+	public:
+		AtomTable();
+		~AtomTable();
+
+		//the table used for channel addresses.
+		static AtomTable& GetDefault();
+
+		//returns the atom of value with a reference, interning it first when needed.
+		Atom Intern(const boost::string_ref& value);
+		//returns the atom of value with a reference, or k_no_atom without one when value is not interned.
+		Atom Acquire(const boost::string_ref& value);
+		//k_no_atom is never counted.
+		void AddReference(Atom atom);
+		void Release(Atom atom);
+		//the caller must hold a reference to atom.
+		const std::string& ToString(Atom atom) const;
+	};
+
+	//remembers the atoms of strings that were already looked up, so finding them again does not lock the table.
+	//the cached atoms are referenced, Trim releases them once the cache holds more than k_max_atom_count.
+	//not thread safe, a connection uses one from its strand.
+	class AtomCache
+	{
+	public:
+		static const size_t k_max_atom_count = 64;
+	private:
+		boost::noncopyable _non_copyable;
+
+		AtomTable& _atom_table;
+		boost::unordered_map<boost::string_ref, Atom, AtomTable::StringHash> _string_to_atom;
+
+		void Clear();
+	public:
+		explicit AtomCache(AtomTable& atom_table);
+		~AtomCache();
+
+		//the returned atom stays valid until the next Trim.
+		Atom Find(const boost::string_ref& value);
+		void Trim();
+	};
+}
@@ -0,0 +1,116 @@
+#include "buffer_pool.h"
+#include <cstring>
+
+namespace chromecast
+{
+	using namespace std;
+
+	class BufferPoolService : public boost::asio::io_service::service
+	{
+		void shutdown_service() override { }
+	public:
+		static boost::asio::io_service::id id;
+		BufferPool pool;
+
+		BufferPoolService(boost::asio::io_service& io_service)
+			: boost::asio::io_service::service(io_service)
+		{
+		}
+	};
+
+	boost::asio::io_service::id BufferPoolService::id;
+
+	void BufferPool::Releaser::operator()(std::vector<byte>* buffer) const
+	{
+		if (_pool)
+			_pool->Release(buffer);
+		else
+			delete buffer;
+	}
+
+	size_t BufferPool::GetClassSize(size_t size_class)
+	{
+		return k_smallest_class_size << size_class;
+	}
+
+	void BufferPool::Release(std::vector<byte>* buffer)
+	{
+		unique_ptr<vector<byte>> released(buffer);
+		size_t capacity = released->capacity();
+		lock_guard<mutex> lock(_mutex);
+		if (capacity < k_smallest_class_size || capacity > GetClassSize(k_size_class_count - 1))
+		{
+			++_statistics.discarded;
+			return;
+		}
+
+		//the largest class the buffer can fully serve.
+		size_t size_class = k_size_class_count - 1;
+		while (GetClassSize(size_class) > capacity)
+			--size_class;
+
+		auto& free_buffers = _free_buffers[size_class];
+		if (free_buffers.size() >= k_max_buffers_per_class)
+		{
+			++_statistics.discarded;
+			return;
+		}
+
+		released->clear();
+		free_buffers.push_back(move(released));
+		_statistics.pooled_bytes += capacity;
+	}
+
+	BufferPool& BufferPool::FromIOService(boost::asio::io_service& io_service)
+	{
+		return boost::asio::use_service<BufferPoolService>(io_service).pool;
+	}
+
+	BufferPool::Buffer BufferPool::Acquire(size_t size)
+	{
+		size_t size_class = 0;
+		while (size_class < k_size_class_count && GetClassSize(size_class) < size)
+			++size_class;
+
+		unique_ptr<vector<byte>> buffer;
+		{
+			lock_guard<mutex> lock(_mutex);
+			if (size_class < k_size_class_count && !_free_buffers[size_class].empty())
+			{
+				buffer = move(_free_buffers[size_class].back());
+				_free_buffers[size_class].pop_back();
+				_statistics.pooled_bytes -= buffer->capacity();
+				++_statistics.hits;
+			}
+			else
+				++_statistics.misses;
+		}
+
+		if (!buffer)
+		{
+			buffer = make_unique<vector<byte>>();
+			buffer->reserve(size_class < k_size_class_count ? GetClassSize(size_class) : size);
+		}
+		buffer->resize(size);
+		return Buffer(buffer.release(), Releaser(this));
+	}
+
+	void BufferPool::Resize(Buffer& buffer, size_t size)
+	{
+		if (size <= buffer->capacity())
+		{
+			buffer->resize(size);
+			return;
+		}
+
+		Buffer larger = Acquire(size);
+		memcpy(larger->data(), buffer->data(), buffer->size());
+		buffer = move(larger);
+	}
+
+	BufferPool::Statistics BufferPool::GetStatistics()
+	{
+		lock_guard<mutex> lock(_mutex);
+		return _statistics;
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include "types.h"
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <boost\noncopyable.hpp>
+#include <boost\asio\io_service.hpp>
+
+namespace chromecast
+{
+	class BufferPool
+	{
+		struct Releaser
+		{
+			BufferPool* _pool;
+
+			Releaser(BufferPool* pool = nullptr) : _pool(pool) { }
+			void operator()(std::vector<byte>* buffer) const;
+		};
+
+	public:
+		//a buffer borrowed from the pool, its memory is handed back to the pool instead of being freed once it goes out of scope.
+		typedef std::unique_ptr<std::vector<byte>, Releaser> Buffer;
+
+		struct Statistics
+		{
+			uint64_t hits = 0;
+			uint64_t misses = 0;
+			uint64_t discarded = 0;
+			size_t pooled_bytes = 0;
+		};
+
+		//buffers are pooled in power of two size classes from 256 bytes up to 1 MiB, larger buffers are freed on release.
+		static const size_t k_smallest_class_size = 256;
+		static const size_t k_size_class_count = 13;
+		static const size_t k_max_buffers_per_class = 64;
+
+	private:
+		boost::noncopyable _non_copyable;
+		std::mutex _mutex;
+		std::array<std::vector<std::unique_ptr<std::vector<byte>>>, k_size_class_count> _free_buffers;
+		Statistics _statistics;
+
+		static size_t GetClassSize(size_t size_class);
+		void Release(std::vector<byte>* buffer);
+	public:
+		BufferPool() = default;
+
+		//the pool shared by every connection running on the given io_service.
+		static BufferPool& FromIOService(boost::asio::io_service& io_service);
+
+		Buffer Acquire(size_t size);
+		//resizes a buffer keeping its content, moving it to a larger size class when it does not fit its current one.
+		void Resize(Buffer& buffer, size_t size);
+
+		Statistics GetStatistics();
+	};
+}
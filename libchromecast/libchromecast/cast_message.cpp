@@ -1,128 +1,354 @@
-#include "cast_message.h"
-#include "google_cast_message.h"
-
-#include <sstream>
-
-//#include <boost/locale.hpp>
-#include <google/protobuf/io/zero_copy_stream_impl.h>
-#include <google/protobuf/io/coded_stream.h>
-
-namespace chromecast
-{
-	CastMessage::Address::Address(const std::string& source_id, const std::string& destination_id, const std::string& namespace_id)
-		: _source(source_id),
-		_destination(destination_id),
-		_namespace(namespace_id)
-	{
-	}
-
-	std::string CastMessage::Address::ToString() const
-	{
-		std::stringstream stream;
-		stream << "Source: " << _source << std::endl;
-		stream << "Destination: " << _destination << std::endl;
-		stream << "Namespace: " << _namespace << std::endl;
-		return stream.str();
-	}
-
-	bool CastMessage::Address::operator<(const Address& other) const
-	{
-		int source_id_compare = _source.compare(other._source);
-		if (source_id_compare != 0)
-			return source_id_compare == -1;
-
-		int namespace_id_compare = _namespace.compare(other._namespace);
-		if (namespace_id_compare != 0)
-			return namespace_id_compare == -1;
-
-		if (_destination == "*")
-			return other._destination != "*";
-
-		return _destination < other._destination;
-	}
-
-	std::string CastMessage::ToString() const
-	{
-		std::stringstream stream;
-		stream << address.ToString() << std::endl;
-		stream << "Payload: " << std::endl;
-		if (payload_type == CastMessage::ePayloadType::String)
-			stream << payload_utf8 << std::endl;
-		else
-		{
-			uint32_t count = 0;
-			for (byte b : payload_binary)
-			{
-				stream << b;
-				++count;
-				if (count % 10 == 0)
-					stream << std::endl;
-				else if (count % 5 == 0)
-					stream << ' ';
-			}
-			stream << std::endl;
-		}
-		return stream.str();
-	}
-
-	void CastMessage::Serialize(boost::asio::streambuf& buffer, bool save)
-	{
-		//auto locale = boost::locale::generator().generate("");
-
-		using namespace google::protobuf::io;
-		typedef extensions::core_api::cast_channel::CastMessage ChromeCastMessage;
-
-		if (save)
-		{
-			ChromeCastMessage msg;
-			msg.set_protocol_version(ChromeCastMessage::ProtocolVersion::CastMessage_ProtocolVersion_CASTV2_1_0);
-			msg.set_source_id(address._source);
-			msg.set_destination_id(address._destination);
-			msg.set_namespace_(address._namespace);
-			if (payload_type == CastMessage::ePayloadType::String)
-			{
-				msg.set_payload_type(ChromeCastMessage::PayloadType::CastMessage_PayloadType_STRING);
-				//std::string utf8_payload = boost::locale::conv::to_utf<char>(payload_utf8, locale);
-				msg.set_payload_utf8(payload_utf8);
-			}
-			else
-			{
-				if (payload_binary.empty())
-					throw std::exception("cannot send a empty binary message");
-				msg.set_payload_type(ChromeCastMessage::PayloadType::CastMessage_PayloadType_BINARY);
-				msg.set_payload_binary(&payload_binary[0], payload_binary.size());
-			}
-			std::ostream stream(&buffer);
-			OstreamOutputStream output_stream(&stream);
-			CodedOutputStream coded_output_stream(&output_stream);
-			if (!msg.SerializeToCodedStream(&coded_output_stream))
-				throw std::exception("could not store message");
-		}
-		else
-		{
-			ChromeCastMessage msg;
-			std::istream stream(&buffer);
-			IstreamInputStream input_stream(&stream);
-			CodedInputStream coded_input_stream(&input_stream);
-			if (!msg.ParseFromCodedStream(&coded_input_stream))
-				throw std::exception("could not load message");
-
-			protocol_version = static_cast<eProtocolVersion>(msg.protocol_version());
-			address._source = msg.source_id();
-			address._destination = msg.destination_id();
-			address._namespace = msg.namespace_();
-			if (msg.payload_type() == ChromeCastMessage::PayloadType::CastMessage_PayloadType_STRING)
-			{
-				payload_type = ePayloadType::String;
-				payload_utf8 = msg.payload_utf8();
-				//payload_utf8 = boost::locale::conv::from_utf<char>(payload_utf8, locale);
-			}
-			else
-			{
-				payload_type = ePayloadType::Binary;
-				std::string binary = msg.payload_binary();
-				payload_binary.assign(binary.begin(), binary.end());
-			}
-		}
-	}
+#include "cast_message.h"
+#include "json_message.h"
+#include "utils.h"
+
+#include <sstream>
+#include <boost/endian/arithmetic.hpp>
+
+//#include <boost/locale.hpp>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
+namespace chromecast
+{
+	CastMessage::Address::Address(const boost::string_ref& source_id, const boost::string_ref& destination_id, const boost::string_ref& namespace_id)
+	{
+		AtomTable& atom_table = AtomTable::GetDefault();
+		_source = atom_table.Intern(source_id);
+		_destination = atom_table.Intern(destination_id);
+		_namespace = atom_table.Intern(namespace_id);
+	}
+
+	CastMessage::Address::Address(const Address& other)
+		: _source(other._source),
+		_destination(other._destination),
+		_namespace(other._namespace)
+	{
+		AtomTable& atom_table = AtomTable::GetDefault();
+		atom_table.AddReference(_source);
+		atom_table.AddReference(_destination);
+		atom_table.AddReference(_namespace);
+	}
+
+	CastMessage::Address::Address(Address&& other)
+		: _source(other._source),
+		_destination(other._destination),
+		_namespace(other._namespace)
+	{
+		other._source = other._destination = other._namespace = AtomTable::k_no_atom;
+	}
+
+	CastMessage::Address& CastMessage::Address::operator=(const Address& other)
+	{
+		Address copy(other);
+		return *this = std::move(copy);
+	}
+
+	CastMessage::Address& CastMessage::Address::operator=(Address&& other)
+	{
+		std::swap(_source, other._source);
+		std::swap(_destination, other._destination);
+		std::swap(_namespace, other._namespace);
+		return *this;
+	}
+
+	CastMessage::Address::~Address()
+	{
+		AtomTable& atom_table = AtomTable::GetDefault();
+		atom_table.Release(_source);
+		atom_table.Release(_destination);
+		atom_table.Release(_namespace);
+	}
+
+	const std::string& CastMessage::Address::GetSource() const
+	{
+		return AtomTable::GetDefault().ToString(_source);
+	}
+
+	const std::string& CastMessage::Address::GetDestination() const
+	{
+		return AtomTable::GetDefault().ToString(_destination);
+	}
+
+	const std::string& CastMessage::Address::GetNamespace() const
+	{
+		return AtomTable::GetDefault().ToString(_namespace);
+	}
+
+	std::string CastMessage::Address::ToString() const
+	{
+		std::stringstream stream;
+		stream << "Source: " << GetSource() << std::endl;
+		stream << "Destination: " << GetDestination() << std::endl;
+		stream << "Namespace: " << GetNamespace() << std::endl;
+		return stream.str();
+	}
+
+	//orders by atom, which is stable while the address lives but unrelated to the order of the strings.
+	bool CastMessage::Address::operator<(const Address& other) const
+	{
+		if (_source != other._source)
+			return _source < other._source;
+		if (_namespace != other._namespace)
+			return _namespace < other._namespace;
+		return _destination < other._destination;
+	}
+
+	bool CastMessage::Address::operator==(const Address& other) const
+	{
+		return _source == other._source && _destination == other._destination && _namespace == other._namespace;
+	}
+
+	static void WritePayload(std::ostream& stream, CastMessage::ePayloadType payload_type, const boost::string_ref& payload_utf8, const byte* binary_begin, const byte* binary_end)
+	{
+		stream << "Payload: " << std::endl;
+		if (payload_type == CastMessage::ePayloadType::String)
+			stream << payload_utf8 << std::endl;
+		else
+		{
+			uint32_t count = 0;
+			for (const byte* it = binary_begin; it != binary_end; ++it)
+			{
+				stream << *it;
+				++count;
+				if (count % 10 == 0)
+					stream << std::endl;
+				else if (count % 5 == 0)
+					stream << ' ';
+			}
+			stream << std::endl;
+		}
+	}
+
+	std::string CastMessage::ToString() const
+	{
+		std::stringstream stream;
+		stream << address.ToString() << std::endl;
+		const byte* binary_begin = payload_binary.empty() ? nullptr : &payload_binary[0];
+		WritePayload(stream, payload_type, payload_utf8, binary_begin, binary_begin + payload_binary.size());
+		return stream.str();
+	}
+
+	namespace
+	{
+		using google::protobuf::io::CodedOutputStream;
+		using google::protobuf::internal::WireFormatLite;
+
+		enum eField
+		{
+			ProtocolVersion = 1,
+			SourceId = 2,
+			DestinationId = 3,
+			Namespace = 4,
+			PayloadType = 5,
+			PayloadUtf8 = 6,
+			PayloadBinary = 7
+		};
+
+		//all of the cast message field numbers are below 16 so every tag is encoded into a single byte.
+		size_t LengthDelimitedSize(size_t length)
+		{
+			return 1 + CodedOutputStream::VarintSize32(static_cast<uint32_t>(length)) + length;
+		}
+
+		size_t EnumSize(int value)
+		{
+			return 1 + CodedOutputStream::VarintSize32SignExtended(value);
+		}
+
+		byte* WriteLengthDelimited(eField field, const void* data, size_t length, byte* target)
+		{
+			target = WireFormatLite::WriteTagToArray(field, WireFormatLite::WIRETYPE_LENGTH_DELIMITED, target);
+			target = CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(length), target);
+			return CodedOutputStream::WriteRawToArray(data, static_cast<int>(length), target);
+		}
+
+		byte* WriteString(eField field, const std::string& value, byte* target)
+		{
+			return WriteLengthDelimited(field, value.data(), value.size(), target);
+		}
+	}
+
+	size_t CastMessage::GetEncodedSize() const
+	{
+		size_t size = EnumSize(static_cast<int>(protocol_version));
+		size += LengthDelimitedSize(address.GetSource().size());
+		size += LengthDelimitedSize(address.GetDestination().size());
+		size += LengthDelimitedSize(address.GetNamespace().size());
+		size += EnumSize(static_cast<int>(payload_type));
+		if (payload_type == CastMessage::ePayloadType::String)
+			return size + LengthDelimitedSize(payload_utf8.size());
+
+		//checked here rather than in Encode so nothing is queued for a message that cannot be sent.
+		if (payload_binary.empty())
+			throw std::exception("cannot send a empty binary message");
+		return size + LengthDelimitedSize(payload_binary.size());
+	}
+
+	byte* CastMessage::Encode(byte* target) const
+	{
+		target = WireFormatLite::WriteEnumToArray(ProtocolVersion, static_cast<int>(protocol_version), target);
+		target = WriteString(SourceId, address.GetSource(), target);
+		target = WriteString(DestinationId, address.GetDestination(), target);
+		target = WriteString(Namespace, address.GetNamespace(), target);
+		target = WireFormatLite::WriteEnumToArray(PayloadType, static_cast<int>(payload_type), target);
+		if (payload_type == CastMessage::ePayloadType::String)
+			return WriteString(PayloadUtf8, payload_utf8, target);
+		return WriteLengthDelimited(PayloadBinary, &payload_binary[0], payload_binary.size(), target);
+	}
+
+	EncodedFrame CastMessage::EncodeFrame() const
+	{
+		size_t message_size = GetEncodedSize();
+		boost::endian::big_uint32_t packet_size = static_cast<uint32_t>(message_size);
+
+		auto frame = std::make_shared<std::vector<byte>>(sizeof(packet_size) + message_size);
+		memcpy(frame->data(), &packet_size, sizeof(packet_size));
+		Encode(frame->data() + sizeof(packet_size));
+		return frame;
+	}
+
+	CastMessage::Address CastMessageView::Address::ToAddress() const
+	{
+		return CastMessage::Address(_source, _destination, _namespace);
+	}
+
+	std::string CastMessageView::Address::ToString() const
+	{
+		std::stringstream stream;
+		stream << "Source: " << _source << std::endl;
+		stream << "Destination: " << _destination << std::endl;
+		stream << "Namespace: " << _namespace << std::endl;
+		return stream.str();
+	}
+
+	static bool ReadStringView(google::protobuf::io::CodedInputStream& stream, const byte* data, boost::string_ref& value)
+	{
+		uint32_t length = 0;
+		if (!stream.ReadVarint32(&length))
+			return false;
+
+		//the stream was created over the whole frame, so the current position is an offset into the frame buffer.
+		const char* begin = reinterpret_cast<const char*>(data) + stream.CurrentPosition();
+		if (!stream.Skip(length))
+			return false;
+		value = boost::string_ref(begin, length);
+		return true;
+	}
+
+	bool CastMessageView::Parse(const byte* data, size_t size)
+	{
+		using google::protobuf::io::CodedInputStream;
+
+		CodedInputStream stream(data, static_cast<int>(size));
+		uint32_t found_fields = 0;
+		_writable = false;
+		_json.reset();
+		while (uint32_t tag = stream.ReadTag())
+		{
+			uint32_t field = WireFormatLite::GetTagFieldNumber(tag);
+			bool length_delimited = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_LENGTH_DELIMITED;
+			bool varint = WireFormatLite::GetTagWireType(tag) == WireFormatLite::WIRETYPE_VARINT;
+			uint32_t value = 0;
+			bool parsed = true;
+			if (field == ProtocolVersion && varint)
+			{
+				parsed = stream.ReadVarint32(&value);
+				protocol_version = static_cast<CastMessage::eProtocolVersion>(value);
+			}
+			else if (field == SourceId && length_delimited)
+				parsed = ReadStringView(stream, data, address._source);
+			else if (field == DestinationId && length_delimited)
+				parsed = ReadStringView(stream, data, address._destination);
+			else if (field == Namespace && length_delimited)
+				parsed = ReadStringView(stream, data, address._namespace);
+			else if (field == PayloadType && varint)
+			{
+				parsed = stream.ReadVarint32(&value);
+				payload_type = static_cast<CastMessage::ePayloadType>(value);
+			}
+			else if (field == PayloadUtf8 && length_delimited)
+				parsed = ReadStringView(stream, data, payload_utf8);
+			else if (field == PayloadBinary && length_delimited)
+			{
+				boost::string_ref binary;
+				parsed = ReadStringView(stream, data, binary);
+				const byte* binary_begin = reinterpret_cast<const byte*>(binary.data());
+				payload_binary = BinaryPayload(binary_begin, binary_begin + binary.size());
+			}
+			else
+			{
+				parsed = WireFormatLite::SkipField(&stream, tag);
+				field = 0;
+			}
+
+			if (!parsed)
+				return false;
+			found_fields |= (1 << field);
+		}
+
+		//every field apart from the payload itself is marked as required by cast_channel.proto.
+		const uint32_t required_fields = (1 << ProtocolVersion) | (1 << SourceId) | (1 << DestinationId) | (1 << Namespace) | (1 << PayloadType);
+		return stream.ConsumedEntireMessage() && (found_fields & required_fields) == required_fields;
+	}
+
+	bool CastMessageView::Parse(byte* data, size_t size)
+	{
+		bool parsed = Parse(const_cast<const byte*>(data), size);
+		_writable = true;
+		return parsed;
+	}
+
+	CastMessage CastMessageView::ToMessage() const
+	{
+		CastMessage message;
+		message.protocol_version = protocol_version;
+		message.address = address.ToAddress();
+		message.payload_type = payload_type;
+		if (payload_type == CastMessage::ePayloadType::String)
+			message.payload_utf8 = GetPayloadText();
+		else
+			message.payload_binary.assign(payload_binary.begin(), payload_binary.end());
+		return message;
+	}
+
+	const JsonMessage& CastMessageView::GetJson() const
+	{
+		if (!_json)
+		{
+			THROW_ON_ERROR_EX(payload_type != CastMessage::ePayloadType::String, "binary payloads are not json");
+			_json = std::make_shared<JsonMessage>();
+			if (_writable)
+				_json->ParseInsitu(const_cast<char*>(payload_utf8.data()), payload_utf8.size());
+			else
+				_json->Parse(payload_utf8);
+		}
+		return *_json;
+	}
+
+	bool CastMessageView::HasJson() const
+	{
+		return _json != nullptr;
+	}
+
+	bool CastMessageView::IsPayloadParsedInPlace() const
+	{
+		return _writable && _json;
+	}
+
+	std::string CastMessageView::GetPayloadText() const
+	{
+		return IsPayloadParsedInPlace() ? _json->ToString() : payload_utf8.to_string();
+	}
+
+	std::string CastMessageView::ToString() const
+	{
+		std::stringstream stream;
+		stream << address.ToString() << std::endl;
+		if (IsPayloadParsedInPlace())
+			WritePayload(stream, payload_type, GetPayloadText(), payload_binary.begin(), payload_binary.end());
+		else
+			WritePayload(stream, payload_type, payload_utf8, payload_binary.begin(), payload_binary.end());
+		return stream.str();
+	}
 }
\ No newline at end of file
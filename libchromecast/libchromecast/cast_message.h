@@ -1,48 +1,116 @@
-#pragma once
-#include <string>
-#include <vector>
-#include <boost/asio/streambuf.hpp>
-
-#include "types.h"
-
-namespace chromecast
-{
-	struct CastMessage
-	{
-		struct Address
-		{
-			std::string _source;
-			std::string _destination;
-			std::string _namespace;
-
-			Address() = default;
-			Address(const std::string& source_id, const std::string& destination_id, const std::string& namespace_id);
-
-			bool operator<(const Address& other) const;
-			std::string ToString() const;
-		};
-
-		enum class eProtocolVersion : int
-		{
-			Version_2_1_0 = 0
-		};
-
-		enum class ePayloadType : int
-		{
-			String = 0,
-			Binary = 1
-		};
-
-		eProtocolVersion protocol_version = eProtocolVersion::Version_2_1_0;
-
-		Address address;
-
-		ePayloadType payload_type;
-		std::string payload_utf8;
-		std::vector<byte> payload_binary;
-
-		std::string ToString() const;
-
-		void Serialize(boost::asio::streambuf& buffer, bool save);
-	};
+#pragma once
+#include <string>
+#include <vector>
+#include <memory>
+#include <boost/utility/string_ref.hpp>
+#include <boost/range/iterator_range.hpp>
+
+#include "types.h"
+#include "atom_table.h"
+
+namespace chromecast
+{
+	class JsonMessage;
+
+	//a message encoded together with the length prefix of its frame, constant messages are encoded once and queued from it on every send.
+	typedef std::shared_ptr<const std::vector<byte>> EncodedFrame;
+
+	struct CastMessage
+	{
+		//the ids are interned in the default atom table, so copying and comparing an address never touches the strings.
+		//they are only materialized when the message is encoded or printed.
+		//an address references its atoms, the transport id of a finished session is dropped with the last address naming it.
+		struct Address
+		{
+			Atom _source = AtomTable::k_no_atom;
+			Atom _destination = AtomTable::k_no_atom;
+			Atom _namespace = AtomTable::k_no_atom;
+
+			Address() = default;
+			Address(const boost::string_ref& source_id, const boost::string_ref& destination_id, const boost::string_ref& namespace_id);
+			Address(const Address& other);
+			Address(Address&& other);
+			Address& operator=(const Address& other);
+			Address& operator=(Address&& other);
+			~Address();
+
+			const std::string& GetSource() const;
+			const std::string& GetDestination() const;
+			const std::string& GetNamespace() const;
+
+			bool operator<(const Address& other) const;
+			bool operator==(const Address& other) const;
+			std::string ToString() const;
+		};
+
+		enum class eProtocolVersion : int
+		{
+			Version_2_1_0 = 0
+		};
+
+		enum class ePayloadType : int
+		{
+			String = 0,
+			Binary = 1
+		};
+
+		eProtocolVersion protocol_version = eProtocolVersion::Version_2_1_0;
+
+		Address address;
+
+		ePayloadType payload_type;
+		std::string payload_utf8;
+		std::vector<byte> payload_binary;
+
+		std::string ToString() const;
+
+		//size of the protobuf encoded message, without the length prefix of the frame.
+		size_t GetEncodedSize() const;
+		//writes the protobuf encoding of the message into target which must hold GetEncodedSize() bytes, returns the end of the written data.
+		byte* Encode(byte* target) const;
+		EncodedFrame EncodeFrame() const;
+	};
+
+	//non owning view of a received message, the referenced data lives inside the frame buffer it was parsed from
+	//so a view must not outlive the dispatch of that frame.
+	struct CastMessageView
+	{
+		struct Address
+		{
+			boost::string_ref _source;
+			boost::string_ref _destination;
+			boost::string_ref _namespace;
+
+			CastMessage::Address ToAddress() const;
+			std::string ToString() const;
+		};
+
+		typedef boost::iterator_range<const byte*> BinaryPayload;
+
+		CastMessage::eProtocolVersion protocol_version = CastMessage::eProtocolVersion::Version_2_1_0;
+
+		Address address;
+
+		CastMessage::ePayloadType payload_type = CastMessage::ePayloadType::String;
+		boost::string_ref payload_utf8;
+		BinaryPayload payload_binary;
+
+		bool Parse(const byte* data, size_t size);
+		//a view of a writable buffer parses its json payload in place, the strings of the document point into the buffer instead of being copied.
+		bool Parse(byte* data, size_t size);
+		CastMessage ToMessage() const;
+		std::string ToString() const;
+
+		//the string payload parsed on first use, every channel the message is delivered to gets the same document.
+		//not thread safe, a view handed to several threads has to be parsed before.
+		const JsonMessage& GetJson() const;
+		//whether GetJson already built the document, the status channels decode the text themselves when nobody did.
+		bool HasJson() const;
+		//parsing in place overwrites payload_utf8, the text is then written from the document.
+		bool IsPayloadParsedInPlace() const;
+		std::string GetPayloadText() const;
+	private:
+		bool _writable = false;
+		mutable std::shared_ptr<JsonMessage> _json;
+	};
 }
\ No newline at end of file
@@ -1,81 +1,129 @@
-#include "channel.h"
-#include "connection.h"
-#include "utils.h"
-#include <iostream>
-
-namespace chromecast
-{
-	using namespace std;
-
-	void ChromecastChannel::OnSending(const CastMessage& message)
-	{
-	}
-
-	void ChromecastChannel::OnMessage(const CastMessage& message)
-	{
-		bool handled = false;
-		if (message.payload_type == CastMessage::ePayloadType::Binary)
-			handled = OnMessage(message.payload_binary);
-		else if (message.payload_type == CastMessage::ePayloadType::String)
-			handled = OnMessage(message.payload_utf8);
-		else
-			THROW_ON_ERROR_EX(true, "unrecognized message payload type, message: " + message.ToString());
-
-		if (!handled)
-			OnUnhandledMessage(message);
-	}
-
-	bool ChromecastChannel::OnMessage(const std::string& message)
-	{
-		return false;
-	}
-
-	bool ChromecastChannel::OnMessage(const std::vector<byte>& message)
-	{
-		return false;
-	}
-
-	void ChromecastChannel::OnUnhandledMessage(const CastMessage& message)
-	{
-		//if another client is connected and sending commands then we can get the broadcasted response for it commands.
-		if (message.address._destination != "*")
-			THROW_ON_ERROR_EX(true, "unhandled message: " + message.ToString());
-	}
-
-	ChromecastChannel::ChromecastChannel(ChromecastConnection& connection, const ChromecastChannel::Address& address)
-		: _address(address),
-		_connection(connection)
-	{
-		_connection.RegisterChannel(*this);
-	}
-
-	ChromecastChannel::~ChromecastChannel()
-	{
-		_connection.UnregisterChannel(*this);
-	}
-
-	void ChromecastChannel::Send(const std::string& json_message)
-	{
-		CastMessage message;
-		message.payload_type = CastMessage::ePayloadType::String;
-		message.payload_utf8 = json_message;
-		Send(move(message));
-	}
-
-	void ChromecastChannel::Send(const vector<byte>& binary_message)
-	{
-		CastMessage message;
-		message.payload_type = CastMessage::ePayloadType::Binary;
-		message.payload_binary = binary_message;
-		Send(move(message));
-	}
-
-	void ChromecastChannel::Send(CastMessage&& message)
-	{
-		message.address = _address;
-		//TODO pass a copy of the message so OnSending won't be able to modify the message using const_cast?
-		OnSending(message);
-
-		_connection.AsyncWrite(move(message));
-	}
+#include "channel.h"
+#include "connection.h"
+#include "utils.h"
+#include <iostream>
+
+namespace chromecast
+{
+	using namespace std;
+
+	void ChromecastChannel::OnSending(const CastMessage& message)
+	{
+	}
+
+	void ChromecastChannel::OnMessage(const CastMessageView& message)
+	{
+		bool handled = false;
+		if (message.payload_type == CastMessage::ePayloadType::Binary)
+			handled = OnMessage(message.payload_binary);
+		else if (message.payload_type == CastMessage::ePayloadType::String)
+			handled = OnTextMessage(message);
+		else
+			THROW_ON_ERROR_EX(true, "unrecognized message payload type, message: " + message.ToString());
+
+		if (!handled)
+			OnUnhandledMessage(message);
+	}
+
+	bool ChromecastChannel::OnTextMessage(const CastMessageView& message)
+	{
+		if (!message.IsPayloadParsedInPlace())
+			return OnMessage(message.payload_utf8);
+
+		//another channel of the message already parsed the payload over its text.
+		std::string text = message.GetPayloadText();
+		return OnMessage(boost::string_ref(text));
+	}
+
+	bool ChromecastChannel::OnMessage(const boost::string_ref& message)
+	{
+		return false;
+	}
+
+	bool ChromecastChannel::OnMessage(const CastMessageView::BinaryPayload& message)
+	{
+		return false;
+	}
+
+	void ChromecastChannel::OnUnhandledMessage(const CastMessageView& message)
+	{
+		//if another client is connected and sending commands then we can get the broadcasted response for it commands.
+		if (message.address._destination != "*")
+			THROW_ON_ERROR_EX(true, "unhandled message: " + message.ToString());
+	}
+
+	ChromecastChannel::ChromecastChannel(ChromecastConnection& connection, const ChromecastChannel::Address& address, bool handled_on_strand)
+		: _address(address),
+		_handled_on_strand(handled_on_strand),
+		_connection(connection)
+	{
+	}
+
+	ChromecastChannel::~ChromecastChannel()
+	{
+		//only a last resort, the derived members are already gone. it keeps a forgotten channel from staying registered.
+		Detach();
+	}
+
+	void ChromecastChannel::Attach()
+	{
+		THROW_ON_ERROR_EX(_attached, "channel " + _address.ToString() + " is already attached");
+		_connection.RegisterChannel(*this);
+		_attached = true;
+	}
+
+	void ChromecastChannel::Detach()
+	{
+		if (!_attached)
+			return;
+		_attached = false;
+		_connection.UnregisterChannel(*this);
+	}
+
+	void ChromecastChannel::Send(const std::string& json_message)
+	{
+		CastMessage message;
+		message.payload_type = CastMessage::ePayloadType::String;
+		message.payload_utf8 = json_message;
+		Send(move(message));
+	}
+
+	void ChromecastChannel::Send(std::string&& json_message)
+	{
+		CastMessage message;
+		message.payload_type = CastMessage::ePayloadType::String;
+		message.payload_utf8 = move(json_message);
+		Send(move(message));
+	}
+
+	void ChromecastChannel::Send(const vector<byte>& binary_message)
+	{
+		CastMessage message;
+		message.payload_type = CastMessage::ePayloadType::Binary;
+		message.payload_binary = binary_message;
+		Send(move(message));
+	}
+
+	void ChromecastChannel::Send(CastMessage&& message)
+	{
+		message.address = _address;
+		//TODO pass a copy of the message so OnSending won't be able to modify the message using const_cast?
+		OnSending(message);
+
+		_connection.AsyncWrite(move(message));
+	}
+
+	void ChromecastChannel::Send(const EncodedFrame& frame)
+	{
+		_connection.AsyncWrite(frame);
+	}
+
+	EncodedFrame ChromecastChannel::EncodeFrame(const std::string& json_message) const
+	{
+		CastMessage message;
+		message.address = _address;
+		message.payload_type = CastMessage::ePayloadType::String;
+		message.payload_utf8 = json_message;
+		return message.EncodeFrame();
+	}
 }
\ No newline at end of file
@@ -1,34 +1,69 @@
-#pragma once
-#include "cast_message.h"
-#include <boost\noncopyable.hpp>
-
-namespace chromecast
-{
-	class ChromecastConnection;
-	class ChromecastChannel
-	{
-	public:
-		typedef CastMessage::Address Address;
-	private:
-		CastMessage::Address _address;
-		boost::noncopyable _noncopyable;
-	protected:
-		ChromecastConnection& _connection;
-
-		virtual void OnSending(const CastMessage& message);
-
-		virtual bool OnMessage(const std::string& message);
-		virtual bool OnMessage(const std::vector<byte>& message);
-		virtual void OnUnhandledMessage(const CastMessage& message);
-	public:
-		ChromecastChannel(ChromecastConnection& connection, const ChromecastChannel::Address& address);
-		~ChromecastChannel();
-
-		const Address& GetAddress() const { return _address; }
-		void Send(const std::string& json_message);
-		void Send(const std::vector<byte>& binary_message);
-		void Send(CastMessage&& message);
-
-		virtual void OnMessage(const CastMessage& message);
-	};
+#pragma once
+#include "cast_message.h"
+#include <memory>
+#include <boost\noncopyable.hpp>
+
+namespace chromecast
+{
+	class ChromecastConnection;
+	class ChromecastChannel
+	{
+	public:
+		typedef CastMessage::Address Address;
+	private:
+		CastMessage::Address _address;
+		bool _handled_on_strand;
+		bool _attached = false;
+		boost::noncopyable _noncopyable;
+	protected:
+		ChromecastConnection& _connection;
+
+		virtual void OnSending(const CastMessage& message);
+
+		//called for string payloads, channels speaking json use message.GetJson() so the payload is parsed once for all of them.
+		//passes the payload to OnMessage by default.
+		virtual bool OnTextMessage(const CastMessageView& message);
+		virtual bool OnMessage(const boost::string_ref& message);
+		virtual bool OnMessage(const CastMessageView::BinaryPayload& message);
+		virtual void OnUnhandledMessage(const CastMessageView& message);
+
+		//encodes a message of the channel address once, for messages the channel keeps sending unchanged.
+		EncodedFrame EncodeFrame(const std::string& json_message) const;
+	public:
+		//a channel handled on the strand keeps handling its messages on the strand of the connection when the connection has a handler executor.
+		ChromecastChannel(ChromecastConnection& connection, const ChromecastChannel::Address& address, bool handled_on_strand = false);
+		virtual ~ChromecastChannel();
+
+		//a channel receives messages only while it is attached to its connection. its handlers may run on other threads,
+		//so it is attached once the most derived channel is constructed and detached before any derived member is destroyed.
+		//ChromecastChannelFactory and ChannelPtr do both, an owner holding a channel by value calls them itself.
+		void Attach();
+		//waits for a message the channel is handling on another thread, does nothing when the channel is not attached.
+		void Detach();
+
+		const Address& GetAddress() const { return _address; }
+		bool IsHandledOnStrand() const { return _handled_on_strand; }
+		void Send(const std::string& json_message);
+		void Send(std::string&& json_message);
+		void Send(const std::vector<byte>& binary_message);
+		void Send(CastMessage&& message);
+		//sends a frame made by EncodeFrame, OnSending is not called for it.
+		void Send(const EncodedFrame& frame);
+
+		virtual void OnMessage(const CastMessageView& message);
+	};
+
+	//detaches a channel before deleting it.
+	template <typename TChannel>
+	struct ChannelDeleter
+	{
+		void operator()(TChannel* channel) const
+		{
+			channel->Detach();
+			delete channel;
+		}
+	};
+
+	template <typename TChannel>
+	using ChannelPtr = std::unique_ptr<TChannel, ChannelDeleter<TChannel>>;
 }
\ No newline at end of file
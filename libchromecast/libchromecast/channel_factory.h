@@ -1,32 +1,37 @@
-#pragma once
-#include "channel.h"
-#include <boost\asio\io_service.hpp>
-
-namespace chromecast
-{
-	class ChromecastConnection;
-	class ChromecastChannelFactory
-	{
-		boost::noncopyable _non_copyable;
-		ChromecastConnection& _connection;
-		boost::asio::io_service& _io_service;
-	public:
-		ChromecastChannelFactory(boost::asio::io_service& io_service, ChromecastConnection& connection)
-			: _connection(connection),
-			_io_service(io_service)
-		{
-		}
-
-		template <typename TChannel, typename ...TArgs>
-		std::unique_ptr<TChannel> CreateChannel(TArgs ...Args)
-		{
-			return std::make_unique<TChannel>(_connection, Args...);
-		}
-
-		template <typename TChannel, typename ...TArgs>
-		std::unique_ptr<TChannel> CreateIOServiceChannel(TArgs ...Args)
-		{
-			return std::make_unique<TChannel>(_io_service, _connection, Args...);
-		}
-	};
+#pragma once
+#include "channel.h"
+#include <boost\asio\io_service.hpp>
+
+namespace chromecast
+{
+	class ChromecastConnection;
+	//creates channels attached to the connection, a channel is attached only after its most derived constructor completed.
+	class ChromecastChannelFactory
+	{
+		boost::noncopyable _non_copyable;
+		ChromecastConnection& _connection;
+		boost::asio::io_service& _io_service;
+	public:
+		ChromecastChannelFactory(boost::asio::io_service& io_service, ChromecastConnection& connection)
+			: _connection(connection),
+			_io_service(io_service)
+		{
+		}
+
+		template <typename TChannel, typename ...TArgs>
+		ChannelPtr<TChannel> CreateChannel(TArgs ...Args)
+		{
+			ChannelPtr<TChannel> channel(new TChannel(_connection, Args...));
+			channel->Attach();
+			return channel;
+		}
+
+		template <typename TChannel, typename ...TArgs>
+		ChannelPtr<TChannel> CreateIOServiceChannel(TArgs ...Args)
+		{
+			ChannelPtr<TChannel> channel(new TChannel(_io_service, _connection, Args...));
+			channel->Attach();
+			return channel;
+		}
+	};
 }
\ No newline at end of file
@@ -1,103 +1,157 @@
-#pragma once
-#include "utils.h"
-#include "connection.h"
-#include "connection_channel.h"
-#include "heartbeat_channel.h"
-#include "receiver_channel.h"
-
-namespace chromecast
-{
-	template <typename TConnection = ChromecastConnection, typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel>
-	class ChromecastClient
-	{
-	protected:
-		TConnection _connection;
-		TReceiverChannel _receiver_channel;
-		THeartbeatChannel _heartbeat_channel;
-		TConnectionChannel _connection_channel;
-
-		static const std::string k_sender0;
-		static const std::string k_receiver0;
-	public:
-		typedef std::function<void(bool)> ConnectedCallback;
-
-		ChromecastClient(boost::asio::io_service& io_service)
-			: _connection(io_service),
-			_heartbeat_channel(io_service, _connection, k_sender0, k_receiver0),
-			_receiver_channel(io_service, _connection, k_sender0, k_receiver0),
-			_connection_channel(_connection, k_sender0, k_receiver0)
-		{
-		}
-
-		void AsyncConnect(std::string device_ip, const ConnectedCallback& callback)
-		{
-			static uint16_t k_chromecast_port = 8009;
-			_connection.AsyncConnect(device_ip, k_chromecast_port,
-				[=](const boost::system::error_code& error)
-			{
-				if (!error)
-				{
-					_connection_channel.Connect();
-					_heartbeat_channel.Start();
-				}
-				if (callback)
-					callback(!error);
-			});
-		}
-
-		void Close()
-		{
-			_connection_channel.Close();
-			_connection.Close();
-		}
-
-		template <typename TApplication>
-		void Launch(const std::function<void(TApplication&)>& callback)
-		{
-			auto application = std::make_shared<TApplication>();
-			Launch(application, [=](bool launched)
-			{
-				THROW_ON_ERROR_EX(!launched, "failed to launch application");
-				if (callback)
-					callback(static_cast<TApplication&>(*application));
-			});
-		}
-
-		template <typename TApplication>
-		void Join(const std::function<void(TApplication&)>& callback)
-		{
-			auto application = std::make_shared<TApplication>();
-			Join(application, [=](bool joined)
-			{
-				THROW_ON_ERROR_EX(!joined, "failed to join application");
-				if (callback)
-					callback(static_cast<TApplication&>(*application));
-			});
-		}
-
-		void Launch(std::shared_ptr<SenderApplication> application, const ReceiverChannel::OperationCompletedCallback& callback)
-		{
-			_receiver_channel.Launch(application, callback);
-		}
-
-		void Join(std::shared_ptr<SenderApplication> application, const ReceiverChannel::OperationCompletedCallback& callback)
-		{
-			_receiver_channel.Join(application, callback);
-		}
-
-		void Mute(bool mute, const ReceiverChannel::OperationCompletedCallback& callback)
-		{
-			_receiver_channel.Mute(mute, callback);
-		}
-
-		void SetVolume(double volume_level, const ReceiverChannel::OperationCompletedCallback& callback)
-		{
-			_receiver_channel.SetVolume(volume_level, callback)
-		}
-	};
-
-	template <typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel, typename TConnection = ChromecastConnection>
-	const std::string ChromecastClient<TReceiverChannel, TConnectionChannel, THeartbeatChannel, TConnection>::k_sender0 = "sender-0";
-	template <typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel, typename TConnection = ChromecastConnection>
-	const std::string ChromecastClient<TReceiverChannel, TConnectionChannel, THeartbeatChannel, TConnection>::k_receiver0 = "receiver-0";
+#pragma once
+#include "utils.h"
+#include "connection.h"
+#include "connection_channel.h"
+#include "heartbeat_channel.h"
+#include "receiver_channel.h"
+
+namespace chromecast
+{
+	template <typename TConnection = ChromecastConnection, typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel>
+	class ChromecastClient
+	{
+	protected:
+		TConnection _connection;
+		TReceiverChannel _receiver_channel;
+		THeartbeatChannel _heartbeat_channel;
+		TConnectionChannel _connection_channel;
+
+		static const std::string k_sender0;
+		static const std::string k_receiver0;
+	public:
+		typedef std::function<void(bool)> ConnectedCallback;
+
+		ChromecastClient(boost::asio::io_service& io_service)
+			: _connection(io_service),
+			_heartbeat_channel(io_service, _connection, k_sender0, k_receiver0),
+			_receiver_channel(io_service, _connection, k_sender0, k_receiver0),
+			_connection_channel(_connection, k_sender0, k_receiver0)
+		{
+			//the channel types may be derived further, they are complete only once the members are constructed.
+			_receiver_channel.Attach();
+			_heartbeat_channel.Attach();
+			_connection_channel.Attach();
+			_connection.SetReconnectedCallback([=]()
+			{
+				_connection_channel.Connect();
+				_heartbeat_channel.Start();
+				_receiver_channel.Rejoin();
+			});
+		}
+
+		//detaches every channel before the first one is destroyed, a handler still running on the executor completes first.
+		~ChromecastClient()
+		{
+			_connection_channel.Detach();
+			_heartbeat_channel.Detach();
+			_receiver_channel.Detach();
+		}
+
+		void SetReconnectPolicy(const ChromecastConnection::ReconnectPolicy& policy)
+		{
+			_connection.SetReconnectPolicy(policy);
+		}
+
+		//the connect timeout bounds resolution, connect and handshake of the device together.
+		void SetConnectTimeout(uint32_t timeout_milliseconds)
+		{
+			_connection.SetConnectTimeout(timeout_milliseconds);
+		}
+
+		//runs the handlers of the receiver and application channels on the executor, see ChromecastConnection::SetHandlerExecutor.
+		void SetHandlerExecutor(boost::asio::io_service* executor)
+		{
+			_connection.SetHandlerExecutor(executor);
+		}
+
+		static const uint16_t k_chromecast_port = 8009;
+
+		//the device is given either by its address or by its host name.
+		void AsyncConnect(std::string device, const ConnectedCallback& callback, uint16_t port = k_chromecast_port)
+		{
+			bool started = _connection.AsyncConnect(device, port,
+				[=](const boost::system::error_code& error)
+			{
+				if (!error)
+				{
+					_connection_channel.Connect();
+					_heartbeat_channel.Start();
+				}
+				if (callback)
+					callback(!error);
+			});
+			if (!started && callback)
+				callback(false);
+		}
+
+		//safe to call from any thread, the CLOSE message is written before the connection shuts down.
+		void Close()
+		{
+			_connection.GetStrand().dispatch([=]()
+			{
+				_heartbeat_channel.Stop();
+				_connection_channel.Close();
+				_connection.Close();
+			});
+		}
+
+		template <typename TApplication>
+		void Launch(const std::function<void(TApplication&)>& callback)
+		{
+			auto application = std::make_shared<TApplication>();
+			Launch(application, [=](bool launched)
+			{
+				THROW_ON_ERROR_EX(!launched, "failed to launch application");
+				if (callback)
+					callback(static_cast<TApplication&>(*application));
+			});
+		}
+
+		template <typename TApplication>
+		void Join(const std::function<void(TApplication&)>& callback)
+		{
+			auto application = std::make_shared<TApplication>();
+			Join(application, [=](bool joined)
+			{
+				THROW_ON_ERROR_EX(!joined, "failed to join application");
+				if (callback)
+					callback(static_cast<TApplication&>(*application));
+			});
+		}
+
+		void Launch(std::shared_ptr<SenderApplication> application, const ReceiverChannel::OperationCompletedCallback& callback)
+		{
+			_receiver_channel.Launch(application, callback);
+		}
+
+		void Join(std::shared_ptr<SenderApplication> application, const ReceiverChannel::OperationCompletedCallback& callback)
+		{
+			_receiver_channel.Join(application, callback);
+		}
+
+		void Mute(bool mute, const ReceiverChannel::OperationCompletedCallback& callback)
+		{
+			_receiver_channel.Mute(mute, callback);
+		}
+
+		void SetVolume(double volume_level, const ReceiverChannel::OperationCompletedCallback& callback)
+		{
+			_receiver_channel.SetVolume(volume_level, callback);
+		}
+
+		void GetStatus(const ReceiverChannel::ReceiverStatusCallback& callback)
+		{
+			_receiver_channel.GetStatus(callback);
+		}
+
+		boost::asio::io_service::strand& GetStrand()
+		{
+			return _connection.GetStrand();
+		}
+	};
+
+	template <typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel, typename TConnection = ChromecastConnection>
+	const std::string ChromecastClient<TReceiverChannel, TConnectionChannel, THeartbeatChannel, TConnection>::k_sender0 = "sender-0";
+	template <typename TReceiverChannel = ReceiverChannel, typename TConnectionChannel = ConnectionChannel, typename THeartbeatChannel = HeartbeatChannel, typename TConnection = ChromecastConnection>
+	const std::string ChromecastClient<TReceiverChannel, TConnectionChannel, THeartbeatChannel, TConnection>::k_receiver0 = "receiver-0";
 }
\ No newline at end of file
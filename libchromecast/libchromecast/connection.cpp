@@ -1,228 +1,890 @@
-#include "connection.h"
-#include "channel.h"
-#include "json_message.h"
-#include "utils.h"
-
-#include <boost/bind.hpp>
-#include <boost/asio/ssl.hpp>
-#include <boost/asio/detail/config.hpp>
-
-namespace chromecast
-{
-	using namespace std;
-	using namespace boost;
-
-	struct TLSSocket
-	{
-		// Type of the ASIO socket being used
-		typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> socket_type;
-
-		socket_type socket;
-
-		TLSSocket(boost::asio::io_service& io_service)
-			: socket(io_service, boost::asio::ssl::context(boost::asio::ssl::context::tlsv12_client))
-		{
-
-		}
-	};
-
-	void TLSConnection::OnConnectCompleted(const boost::system::error_code& error)
-	{
-		if (error)
-		{
-			if (_connection_callback)
-				_connection_callback(error);
-			return;
-		}
-
-		_socket_impl->socket.async_handshake(boost::asio::ssl::stream_base::client, boost::bind(&TLSConnection::OnHandshake, this, boost::asio::placeholders::error));
-	}
-
-	void TLSConnection::OnHandshake(const boost::system::error_code& error)
-	{
-		if (!error)
-			OnConnectionReady();
-		if (_connection_callback)
-			_connection_callback(error);
-	}
-
-	void TLSConnection::AsyncRead(byte* buffer, size_t read_byte_count, const IORequestCompletedCallback& read_completed)
-	{
-		boost::asio::async_read(_socket_impl->socket, boost::asio::buffer(buffer, read_byte_count), read_completed);
-	}
-
-	TLSConnection::TLSConnection(boost::asio::io_service& io_service)
-	{
-		_socket_impl = new TLSSocket(io_service);
-	}
-
-	TLSConnection::~TLSConnection()
-	{
-		try
-		{
-			Close();
-		}
-		catch (std::exception& e)
-		{
-			std::string msg = e.what();
-		}
-		delete _socket_impl;
-	}
-
-	bool TLSConnection::AsyncConnect(std::string ip_address, uint16_t port, const RequestCompletedCallback& callback)
-	{
-		system::error_code error;
-		auto address = boost::asio::ip::address::from_string(ip_address, error);
-		if (error)
-			return false;
-		boost::asio::ip::tcp::endpoint end_point(address, port);
-		AsyncConnect(end_point, callback);
-		return true;
-	}
-
-	void TLSConnection::AsyncConnect(const boost::asio::ip::tcp::endpoint& end_point, const RequestCompletedCallback& callback)
-	{
-		_connection_callback = callback;
-		_socket_impl->socket.set_verify_mode(boost::asio::ssl::verify_none);
-		_socket_impl->socket.lowest_layer().async_connect(end_point, boost::bind(&TLSConnection::OnConnectCompleted, this, boost::asio::placeholders::error));
-	}
-
-	void TLSConnection::Close()
-	{
-		_socket_impl->socket.shutdown();
-	}
-
-	void TLSConnection::EnsureConnectionIsAlive()
-	{
-		byte b = 0;
-		boost::system::error_code error;
-		_socket_impl->socket.write_some(boost::asio::buffer(&b, sizeof(b)), error);
-		THROW_ON_ERROR_EX(error, "invalid application");
-	}
-
-	void TLSConnection::AsyncWrite(boost::asio::streambuf& buffer, const IORequestCompletedCallback& write_completed)
-	{
-		boost::asio::async_write(_socket_impl->socket, buffer, write_completed);
-	}
-
-	void ChromecastConnection::OnConnectionReady()
-	{
-		StartReadingPacketLength();
-	}
-
-	void ChromecastConnection::OnMessage(const CastMessage& message)
-	{
-		if (message.address._destination != "*")
-		{
-			auto it = _channel_address_to_channel.find(message.address);
-			if (it != _channel_address_to_channel.end() && it->second)
-				it->second->OnMessage(message);
-			else
-				OnUnrecognizedAddress(message);
-		}
-		else
-		{
-			for (auto& channel_address_to_channel_pair : _channel_address_to_channel)
-			{
-				if (channel_address_to_channel_pair.first._namespace != message.address._namespace
-					|| channel_address_to_channel_pair.first._source != message.address._source)
-					continue;
-				channel_address_to_channel_pair.second->OnMessage(message);
-			}
-		}
-	}
-
-	void ChromecastConnection::StartReadingPacketLength()
-	{
-		StartReading((byte*)&_current_packet.length, sizeof(_current_packet.length), [=]()
-		{
-			uint32_t packet_length = _current_packet.length;
-			_current_packet.data = make_unique<byte[]>(packet_length);
-			StartReadingData(_current_packet.length);
-		});
-	}
-
-	void ChromecastConnection::StartReadingData(uint32_t remaining_data_byte_count)
-	{
-		StartReading(_current_packet.data.get(), _current_packet.length, [=]()
-		{
-			boost::asio::streambuf buffer;
-			buffer.sputn((char*)_current_packet.data.get(), _current_packet.length);
-
-			CastMessage message;
-			message.Serialize(buffer, false);
-			OnMessage(message);
-			StartReadingPacketLength();
-		});
-	}
-
-	void ChromecastConnection::StartReading(byte* buffer, uint32_t buffer_size, const std::function<void()>& completed_reading)
-	{
-		__super::AsyncRead(buffer, buffer_size, [=](const system::error_code& error, size_t bytes_transferred)
-		{
-			if (error || buffer_size != bytes_transferred)
-			{
-				EnsureConnectionIsAlive();
-				StartReading(buffer + bytes_transferred, buffer_size - bytes_transferred, completed_reading);
-			}
-			else
-				completed_reading();
-		});
-	}
-
-	void ChromecastConnection::OnUnrecognizedAddress(const CastMessage& message)
-	{
-		THROW_ON_ERROR_EX(true, "received message without a clear destination:\n" + message.ToString());
-	}
-
-	ChromecastConnection::ChromecastConnection(boost::asio::io_service& io_service)
-		: TLSConnection(io_service),
-		channel_factory(io_service, *this)
-	{
-	}
-
-	ChromecastConnection::~ChromecastConnection()
-	{
-#ifdef _DEBUG
-		//assert(_channel_address_to_channel.empty());
-#endif
-	}
-
-	void ChromecastConnection::AsyncWrite(CastMessage& message)
-	{
-		boost::asio::streambuf message_buffer;
-		message.Serialize(message_buffer, true);
-
-		auto output_buffer = make_shared<boost::asio::streambuf>();
-		endian::big_uint32_t packet_size = message_buffer.size();
-		output_buffer->sputn((char*)&packet_size, sizeof(packet_size));
-		message.Serialize(*output_buffer, true);
-
-		uint32_t total_size = output_buffer->size();
-		__super::AsyncWrite(*output_buffer, [output_buffer, total_size](const boost::system::error_code& error, size_t bytes_transferred)
-		{
-			THROW_ON_ERROR_EX(error, "failed to write packet data: " + error.message());
-
-			//throwing instead of sending missing data, not encountered a short write.
-			THROW_ON_ERROR_EX(total_size != bytes_transferred, "could only write " + to_string(bytes_transferred) + " out of " + to_string(total_size) + " bytes");
-		});
-	}
-
-	void ChromecastConnection::RegisterChannel(ChromecastChannel& channel)
-	{
-		ChromecastChannel::Address address = channel.GetAddress();
-		swap(address._source, address._destination);
-		auto it = _channel_address_to_channel.find(address);
-		THROW_ON_ERROR_EX(it != _channel_address_to_channel.end(), "address: " + address.ToString() + " already registered");
-		_channel_address_to_channel[address] = &channel;
-	}
-
-	void ChromecastConnection::UnregisterChannel(const ChromecastChannel& channel)
-	{
-		ChromecastChannel::Address address = channel.GetAddress();
-		swap(address._source, address._destination);
-		auto it = _channel_address_to_channel.find(address);
-		THROW_ON_ERROR_EX(it == _channel_address_to_channel.end(), "address " + address.ToString() + " not registered");
-		_channel_address_to_channel.erase(it);
-	}
+#include "connection.h"
+#include "channel.h"
+#include "json_message.h"
+#include "utils.h"
+
+#include <cmath>
+#include <algorithm>
+#include <boost/bind.hpp>
+#include <boost/asio/ssl.hpp>
+#include <boost/asio/detail/config.hpp>
+
+namespace chromecast
+{
+	using namespace std;
+	using namespace boost;
+
+	struct TLSSocket
+	{
+		// Type of the ASIO socket being used
+		typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> socket_type;
+
+		socket_type socket;
+
+		TLSSocket(boost::asio::io_service& io_service, boost::asio::ssl::context& context)
+			: socket(io_service, context)
+		{
+
+		}
+	};
+
+	struct TLSConnection::ConnectOperation
+	{
+		RequestCompletedCallback callback;
+		boost::asio::ip::tcp::resolver resolver;
+		boost::asio::deadline_timer deadline_timer;
+		boost::asio::deadline_timer stagger_timer;
+		std::vector<boost::asio::ip::tcp::endpoint> end_points;
+		size_t next_end_point = 0;
+		std::vector<std::shared_ptr<TLSSocket>> attempts;
+		bool resolving = false;
+		bool completed = false;
+		boost::system::error_code last_error;
+		boost::system::error_code cancel_error;
+
+		ConnectOperation(boost::asio::io_service& io_service, const RequestCompletedCallback& callback)
+			: callback(callback),
+			resolver(io_service),
+			deadline_timer(io_service),
+			stagger_timer(io_service)
+		{
+		}
+	};
+
+	//alternates between the address families, so one unreachable family does not delay the other by a whole list of attempts.
+	static void InterleaveAddressFamilies(std::vector<boost::asio::ip::tcp::endpoint>& end_points, size_t first)
+	{
+		if (end_points.size() - first < 2)
+			return;
+
+		bool first_is_v6 = end_points[first].address().is_v6();
+		std::vector<boost::asio::ip::tcp::endpoint> preferred, other;
+		for (size_t index = first; index < end_points.size(); ++index)
+			(end_points[index].address().is_v6() == first_is_v6 ? preferred : other).push_back(end_points[index]);
+
+		size_t index = first;
+		for (size_t pair = 0; pair < (std::max)(preferred.size(), other.size()); ++pair)
+		{
+			if (pair < preferred.size())
+				end_points[index++] = preferred[pair];
+			if (pair < other.size())
+				end_points[index++] = other[pair];
+		}
+	}
+
+	std::shared_ptr<TLSConnection::ConnectOperation> TLSConnection::StartConnectOperation(const RequestCompletedCallback& callback)
+	{
+		//a new connect supersedes the one still in progress.
+		if (_connect_operation)
+			CancelConnectOperation(_connect_operation, boost::asio::error::operation_aborted);
+
+		auto operation = std::make_shared<ConnectOperation>(_io_service, callback);
+		_connect_operation = operation;
+		if (_connect_timeout_milliseconds != 0)
+		{
+			operation->deadline_timer.expires_from_now(boost::posix_time::milliseconds(_connect_timeout_milliseconds));
+			operation->deadline_timer.async_wait(_strand.wrap([=](const boost::system::error_code& error)
+			{
+				if (error || operation->completed)
+					return;
+
+				CancelConnectOperation(operation, boost::asio::error::timed_out);
+				//a name lookup in progress cannot be interrupted, the deadline does not wait for it.
+				if (operation->attempts.empty())
+					CompleteConnectOperation(operation, nullptr, boost::asio::ip::tcp::endpoint(), boost::asio::error::timed_out);
+			}));
+		}
+		return operation;
+	}
+
+	void TLSConnection::Resolve(std::shared_ptr<ConnectOperation> operation)
+	{
+		boost::asio::ip::tcp::resolver::query query(_host, to_string(_port), boost::asio::ip::tcp::resolver::query::numeric_service);
+		operation->resolving = true;
+		operation->resolver.async_resolve(query, _strand.wrap(boost::bind(&TLSConnection::OnResolved, this, operation, boost::asio::placeholders::error, boost::asio::placeholders::iterator)));
+	}
+
+	void TLSConnection::OnResolved(std::shared_ptr<ConnectOperation> operation, const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator it)
+	{
+		operation->resolving = false;
+		if (error)
+		{
+			if (error != boost::asio::error::operation_aborted)
+				operation->last_error = error;
+		}
+		else if (!operation->completed && !operation->cancel_error)
+		{
+			//an endpoint that is already being tried, like the cached address of a reconnect, is not tried twice.
+			auto& end_points = operation->end_points;
+			for (; it != boost::asio::ip::tcp::resolver::iterator(); ++it)
+			{
+				if (find(end_points.begin(), end_points.end(), it->endpoint()) == end_points.end())
+					end_points.push_back(it->endpoint());
+			}
+			InterleaveAddressFamilies(end_points, operation->next_end_point);
+		}
+
+		if (operation->attempts.empty())
+			StartNextAttempt(operation);
+		else
+			ScheduleNextAttempt(operation);
+	}
+
+	void TLSConnection::StartNextAttempt(std::shared_ptr<ConnectOperation> operation)
+	{
+		if (operation->completed)
+			return;
+
+		if (operation->cancel_error || operation->next_end_point >= operation->end_points.size())
+		{
+			//nothing left to try, the operation fails once the last attempt and the resolution are done.
+			if (operation->attempts.empty() && !operation->resolving)
+			{
+				boost::system::error_code error = operation->cancel_error ? operation->cancel_error : operation->last_error;
+				CompleteConnectOperation(operation, nullptr, boost::asio::ip::tcp::endpoint(), error ? error : boost::asio::error::host_not_found);
+			}
+			return;
+		}
+
+		boost::asio::ip::tcp::endpoint end_point = operation->end_points[operation->next_end_point++];
+		auto socket = std::make_shared<TLSSocket>(_io_service, _tls_context.GetContext());
+		operation->attempts.push_back(socket);
+		socket->socket.lowest_layer().async_connect(end_point, _strand.wrap(boost::bind(&TLSConnection::OnAttemptConnected, this, operation, socket, end_point, boost::asio::placeholders::error)));
+		ScheduleNextAttempt(operation);
+	}
+
+	void TLSConnection::ScheduleNextAttempt(std::shared_ptr<ConnectOperation> operation)
+	{
+		if (operation->next_end_point >= operation->end_points.size())
+			return;
+
+		operation->stagger_timer.expires_from_now(boost::posix_time::milliseconds(_connect_stagger_milliseconds));
+		operation->stagger_timer.async_wait(_strand.wrap([=](const boost::system::error_code& error)
+		{
+			if (!error)
+				StartNextAttempt(operation);
+		}));
+	}
+
+	void TLSConnection::OnAttemptConnected(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error)
+	{
+		if (error || operation->completed || operation->cancel_error)
+			return OnAttemptFailed(operation, socket, error ? error : boost::asio::error::operation_aborted);
+
+		_tls_context.PrepareHandshake(socket->socket.native_handle(), end_point);
+		socket->socket.async_handshake(boost::asio::ssl::stream_base::client, _strand.wrap(boost::bind(&TLSConnection::OnAttemptHandshake, this, operation, socket, end_point, boost::asio::placeholders::error)));
+	}
+
+	void TLSConnection::OnAttemptHandshake(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error)
+	{
+		if (error || operation->completed || operation->cancel_error)
+			return OnAttemptFailed(operation, socket, error ? error : boost::asio::error::operation_aborted);
+
+		_tls_context.OnHandshakeCompleted(socket->socket.native_handle(), end_point);
+		CompleteConnectOperation(operation, socket, end_point, boost::system::error_code());
+	}
+
+	void TLSConnection::OnAttemptFailed(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::system::error_code& error)
+	{
+		boost::system::error_code close_error;
+		socket->socket.lowest_layer().close(close_error);
+		auto& attempts = operation->attempts;
+		attempts.erase(remove(attempts.begin(), attempts.end(), socket), attempts.end());
+
+		if (error != boost::asio::error::operation_aborted)
+			operation->last_error = error;
+		//a failed attempt starts the next one right away instead of waiting for the stagger interval.
+		StartNextAttempt(operation);
+	}
+
+	void TLSConnection::CancelConnectOperation(std::shared_ptr<ConnectOperation> operation, const boost::system::error_code& error)
+	{
+		if (operation->completed || operation->cancel_error)
+			return;
+
+		//the callback is called by the completions of the cancelled operations.
+		operation->cancel_error = error;
+		operation->resolver.cancel();
+		operation->stagger_timer.cancel();
+		boost::system::error_code close_error;
+		for (auto& socket : operation->attempts)
+			socket->socket.lowest_layer().close(close_error);
+	}
+
+	void TLSConnection::CompleteConnectOperation(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error)
+	{
+		operation->completed = true;
+		operation->deadline_timer.cancel();
+		operation->stagger_timer.cancel();
+		operation->resolver.cancel();
+		boost::system::error_code close_error;
+		for (auto& attempt : operation->attempts)
+		{
+			if (attempt != socket)
+				attempt->socket.lowest_layer().close(close_error);
+		}
+		operation->attempts.clear();
+		if (_connect_operation == operation)
+			_connect_operation.reset();
+
+		if (socket)
+		{
+			_socket_impl = socket;
+			_end_point = end_point;
+			OnConnectionReady();
+		}
+		if (operation->callback)
+			operation->callback(error);
+	}
+
+	void TLSConnection::AsyncReadSome(byte* buffer, size_t max_read_byte_count, const IORequestCompletedCallback& read_completed)
+	{
+		auto socket = _socket_impl;
+		socket->socket.async_read_some(boost::asio::buffer(buffer, max_read_byte_count), _strand.wrap([socket, read_completed](const boost::system::error_code& error, size_t bytes_transferred)
+		{
+			read_completed(error, bytes_transferred);
+		}));
+	}
+
+	TLSConnection::TLSConnection(boost::asio::io_service& io_service, TLSContext& tls_context)
+		: _io_service(io_service),
+		_strand(io_service),
+		_tls_context(tls_context)
+	{
+		_socket_impl = std::make_shared<TLSSocket>(io_service, tls_context.GetContext());
+	}
+
+	TLSConnection::~TLSConnection()
+	{
+		Abort();
+	}
+
+	bool TLSConnection::AsyncConnect(std::string host, uint16_t port, const RequestCompletedCallback& callback)
+	{
+		if (host.empty())
+			return false;
+
+		system::error_code error;
+		auto address = boost::asio::ip::address::from_string(host, error);
+		if (!error)
+		{
+			AsyncConnect(boost::asio::ip::tcp::endpoint(address, port), callback);
+			return true;
+		}
+
+		auto operation = StartConnectOperation(callback);
+		_host = host;
+		_port = port;
+		Resolve(operation);
+		return true;
+	}
+
+	void TLSConnection::AsyncConnect(const boost::asio::ip::tcp::endpoint& end_point, const RequestCompletedCallback& callback)
+	{
+		AsyncConnect(std::vector<boost::asio::ip::tcp::endpoint>(1, end_point), callback);
+	}
+
+	void TLSConnection::AsyncConnect(const std::vector<boost::asio::ip::tcp::endpoint>& end_points, const RequestCompletedCallback& callback)
+	{
+		THROW_ON_ERROR_EX(end_points.empty(), "no endpoint to connect to");
+
+		auto operation = StartConnectOperation(callback);
+		_host.clear();
+		_port = 0;
+		operation->end_points = end_points;
+		InterleaveAddressFamilies(operation->end_points, 0);
+		StartNextAttempt(operation);
+	}
+
+	void TLSConnection::AsyncReconnect(const RequestCompletedCallback& callback)
+	{
+		//the cached address is tried right away while the name is resolved again, the device may have moved to another address.
+		auto operation = StartConnectOperation(callback);
+		operation->end_points.push_back(_end_point);
+		if (!_host.empty())
+			Resolve(operation);
+		StartNextAttempt(operation);
+	}
+
+	void TLSConnection::SetConnectTimeout(uint32_t timeout_milliseconds)
+	{
+		_connect_timeout_milliseconds = timeout_milliseconds;
+	}
+
+	uint32_t TLSConnection::GetConnectTimeout() const
+	{
+		return _connect_timeout_milliseconds;
+	}
+
+	void TLSConnection::SetConnectStagger(uint32_t stagger_milliseconds)
+	{
+		_connect_stagger_milliseconds = stagger_milliseconds;
+	}
+
+	void TLSConnection::Close()
+	{
+		auto socket = _socket_impl;
+		socket->socket.async_shutdown(_strand.wrap([socket](const boost::system::error_code&)
+		{
+			//the peer may never answer the close notify, the tcp connection is closed either way.
+			boost::system::error_code error;
+			socket->socket.lowest_layer().close(error);
+		}));
+	}
+
+	void TLSConnection::Abort()
+	{
+		if (_connect_operation)
+			CancelConnectOperation(_connect_operation, boost::asio::error::operation_aborted);
+		boost::system::error_code error;
+		_socket_impl->socket.lowest_layer().close(error);
+	}
+
+	void TLSConnection::AsyncWrite(const byte* buffer, size_t write_byte_count, const IORequestCompletedCallback& write_completed)
+	{
+		auto socket = _socket_impl;
+		boost::asio::async_write(socket->socket, boost::asio::buffer(buffer, write_byte_count), _strand.wrap([socket, write_completed](const boost::system::error_code& error, size_t bytes_transferred)
+		{
+			write_completed(error, bytes_transferred);
+		}));
+	}
+
+	boost::asio::io_service::strand& TLSConnection::GetStrand()
+	{
+		return _strand;
+	}
+
+	void ChromecastConnection::OnConnectionReady()
+	{
+		++_connection_generation;
+		_closing = false;
+		SetState(eConnectionState::Connected);
+		_read_begin = _read_end = 0;
+		size_t read_buffer_size = sizeof(uint32_t) + _max_frame_size;
+		if (!_read_buffer || _read_buffer->size() < read_buffer_size)
+			_read_buffer = _buffer_pool.Acquire(read_buffer_size);
+		StartReading();
+	}
+
+	void ChromecastConnection::HandleMessage(Subscription& subscription, const CastMessageView& message)
+	{
+		lock_guard<recursive_mutex> lock(subscription.handler_mutex);
+		//the subscription may still be part of a snapshot or a queue after the channel was unregistered.
+		if (subscription.registered)
+			subscription.channel->OnMessage(message);
+	}
+
+	void ChromecastConnection::ScheduleQueuedMessage(boost::asio::io_service& executor, std::shared_ptr<Subscription> subscription)
+	{
+		lock_guard<mutex> lock(subscription->queue_mutex);
+		if (subscription->queue.empty())
+		{
+			subscription->queue_scheduled = false;
+			return;
+		}
+
+		executor.post([&executor, subscription]()
+		{
+			HandleQueuedMessage(executor, subscription);
+		});
+	}
+
+	void ChromecastConnection::HandleQueuedMessage(boost::asio::io_service& executor, std::shared_ptr<Subscription> subscription)
+	{
+		std::shared_ptr<ReceivedMessage> received_message;
+		{
+			lock_guard<mutex> lock(subscription->queue_mutex);
+			received_message = std::move(subscription->queue.front());
+			subscription->queue.pop_front();
+		}
+
+		//every message is posted on its own so the channels sharing the executor take turns, the next one is posted even when the handler throws.
+		try
+		{
+			HandleMessage(*subscription, received_message->message);
+		}
+		catch (...)
+		{
+			ScheduleQueuedMessage(executor, subscription);
+			throw;
+		}
+		ScheduleQueuedMessage(executor, subscription);
+	}
+
+	void ChromecastConnection::DispatchToSubscriptions(const Subscriptions& subscriptions, const CastMessageView& message, const byte* encoded_message, size_t encoded_message_size)
+	{
+		//the view points into the read buffer, the queued message gets a copy that is shared by every channel it is delivered to.
+		//the copy is made before any channel handles the view, parsing the payload in place rewrites the bytes it would be copied from.
+		std::shared_ptr<ReceivedMessage> received_message;
+		if (_handler_executor)
+		{
+			bool queued = std::any_of(subscriptions.begin(), subscriptions.end(), [](const std::shared_ptr<Subscription>& subscription)
+			{
+				return !subscription->handled_on_strand;
+			});
+			if (queued)
+			{
+				received_message = std::make_shared<ReceivedMessage>();
+				received_message->encoded_message = _buffer_pool.Acquire(encoded_message_size);
+				memcpy(received_message->encoded_message->data(), encoded_message, encoded_message_size);
+				received_message->message.Parse(received_message->encoded_message->data(), encoded_message_size);
+				//parsed on the strand, the channels handling the copy on the executor only read the document.
+				if (received_message->message.payload_type == CastMessage::ePayloadType::String)
+					received_message->message.GetJson();
+			}
+		}
+
+		for (auto& subscription : subscriptions)
+		{
+			if (!received_message || subscription->handled_on_strand)
+			{
+				HandleMessage(*subscription, message);
+				continue;
+			}
+
+			lock_guard<mutex> lock(subscription->queue_mutex);
+			subscription->queue.push_back(received_message);
+			if (subscription->queue_scheduled)
+				continue;
+			subscription->queue_scheduled = true;
+			boost::asio::io_service& executor = *_handler_executor;
+			executor.post([&executor, subscription]()
+			{
+				HandleQueuedMessage(executor, subscription);
+			});
+		}
+	}
+
+	void ChromecastConnection::OnMessage(const CastMessageView& message, const byte* encoded_message, size_t encoded_message_size)
+	{
+		//the snapshot stays valid until the dispatch completed, even when a handler registers or unregisters channels.
+		std::shared_ptr<const ChannelRegistry> registry = std::atomic_load(&_registry);
+
+		//a string that was never interned is not part of any registered address.
+		//trimmed before the lookups, the atoms found for this message stay referenced until the next one.
+		_atom_cache.Trim();
+		ChannelKey key;
+		key.source = _atom_cache.Find(message.address._source);
+		key.name_space = _atom_cache.Find(message.address._namespace);
+		if (message.address._destination != "*")
+		{
+			key.destination = _atom_cache.Find(message.address._destination);
+			auto it = registry->key_to_subscriptions.find(key);
+			if (it != registry->key_to_subscriptions.end())
+				DispatchToSubscriptions(it->second, message, encoded_message, encoded_message_size);
+			else
+				OnUnrecognizedAddress(message);
+		}
+		else
+		{
+			auto it = registry->broadcast_key_to_subscriptions.find(key);
+			if (it != registry->broadcast_key_to_subscriptions.end())
+				DispatchToSubscriptions(it->second, message, encoded_message, encoded_message_size);
+		}
+	}
+
+	void ChromecastConnection::StartReading()
+	{
+		if (_read_begin != 0)
+		{
+			//only the tail of a partially received frame is left, move it to the front so the next read has room behind it.
+			memmove(_read_buffer->data(), _read_buffer->data() + _read_begin, _read_end - _read_begin);
+			_read_end -= _read_begin;
+			_read_begin = 0;
+		}
+
+		__super::AsyncReadSome(_read_buffer->data() + _read_end, _read_buffer->size() - _read_end, boost::bind(&ChromecastConnection::OnDataRead, this, _connection_generation, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+	}
+
+	void ChromecastConnection::OnDataRead(uint32_t connection_generation, const boost::system::error_code& error, size_t bytes_transferred)
+	{
+		//a read of a socket that was already aborted or replaced.
+		if (connection_generation != _connection_generation || _state != eConnectionState::Connected)
+			return;
+
+		//eof, a reset or a failed ssl record all leave the stream unusable.
+		if (error)
+		{
+			OnConnectionLost(error);
+			return;
+		}
+
+		_read_end += bytes_transferred;
+		DispatchFrames();
+		if (connection_generation == _connection_generation && _state == eConnectionState::Connected)
+			StartReading();
+	}
+
+	void ChromecastConnection::DispatchFrames()
+	{
+		endian::big_uint32_t packet_length;
+		uint32_t connection_generation = _connection_generation;
+		while (_read_end - _read_begin >= sizeof(packet_length) && connection_generation == _connection_generation && _state == eConnectionState::Connected)
+		{
+			byte* frame = _read_buffer->data() + _read_begin;
+			memcpy(&packet_length, frame, sizeof(packet_length));
+			//the read buffer holds a frame of the maximal size, so checking the length is all that is needed for a frame to fit.
+			//the stream cannot be resynchronized after a bad frame, it is handled like a lost connection.
+			if (packet_length > _max_frame_size)
+				return OnConnectionLost(boost::asio::error::message_size);
+
+			size_t frame_size = sizeof(packet_length) + packet_length;
+			if (_read_end - _read_begin < frame_size)
+				break;
+
+			//the view points into the read buffer, it is only valid until the buffer is compacted by the next read.
+			CastMessageView message;
+			if (!message.Parse(frame + sizeof(packet_length), packet_length))
+				return OnConnectionLost(boost::system::errc::make_error_code(boost::system::errc::bad_message));
+			_read_begin += frame_size;
+			OnMessage(message, frame + sizeof(packet_length), packet_length);
+		}
+
+		if (_read_begin == _read_end)
+			_read_begin = _read_end = 0;
+	}
+
+	void ChromecastConnection::OnUnrecognizedAddress(const CastMessageView& message)
+	{
+		THROW_ON_ERROR_EX(true, "received message without a clear destination:\n" + message.ToString());
+	}
+
+	ChromecastConnection::ChromecastConnection(boost::asio::io_service& io_service, TLSContext& tls_context)
+		: TLSConnection(io_service, tls_context),
+		_buffer_pool(BufferPool::FromIOService(io_service)),
+		_max_frame_size(k_default_max_frame_size),
+		_atom_cache(AtomTable::GetDefault()),
+		_registry(std::make_shared<ChannelRegistry>()),
+		_reconnect_timer(io_service),
+		_random(std::random_device()()),
+		channel_factory(io_service, *this)
+	{
+	}
+
+	ChromecastConnection::~ChromecastConnection()
+	{
+#ifdef _DEBUG
+		//assert(_registry->key_to_subscriptions.empty());
+#endif
+	}
+
+	byte* ChromecastConnection::QueueFrame(size_t frame_size)
+	{
+		if (!_pending_frames)
+			_pending_frames = _buffer_pool.Acquire(0);
+
+		size_t offset = _pending_frames->size();
+		_buffer_pool.Resize(_pending_frames, offset + frame_size);
+		++_write_statistics.queued_frames;
+		_write_statistics.pending_bytes += frame_size;
+		return _pending_frames->data() + offset;
+	}
+
+	void ChromecastConnection::StartWriting()
+	{
+		if (_write_in_flight || !_pending_frames || _state != eConnectionState::Connected)
+			return;
+
+		//a single contiguous buffer lets the ssl stream pack the whole batch into as few records as possible.
+		_write_in_flight = std::move(_pending_frames);
+		_frames_in_flight = _write_statistics.queued_frames;
+		_write_statistics.in_flight_bytes = _write_statistics.pending_bytes;
+		_write_statistics.queued_frames = 0;
+		_write_statistics.pending_bytes = 0;
+		++_write_statistics.writes_issued;
+		__super::AsyncWrite(_write_in_flight->data(), _write_in_flight->size(), boost::bind(&ChromecastConnection::OnWriteCompleted, this, _connection_generation, boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+	}
+
+	void ChromecastConnection::OnWriteCompleted(uint32_t connection_generation, const boost::system::error_code& error, size_t bytes_transferred)
+	{
+		size_t total_size = _write_in_flight->size();
+		_write_in_flight.reset();
+		_write_statistics.in_flight_bytes = 0;
+
+		//the batch was written to a socket that is gone, frames queued since belong to the current connection.
+		if (connection_generation != _connection_generation || _state != eConnectionState::Connected)
+		{
+			_frames_in_flight = 0;
+			if (_state == eConnectionState::Connected)
+			{
+				StartWriting();
+				ShutdownIfWritten();
+			}
+			return;
+		}
+
+		//async_write only completes early on an error.
+		if (error || total_size != bytes_transferred)
+		{
+			_frames_in_flight = 0;
+			OnConnectionLost(error ? error : boost::asio::error::connection_reset);
+			return;
+		}
+
+		_write_statistics.frames_written += _frames_in_flight;
+		_write_statistics.bytes_written += bytes_transferred;
+		_frames_in_flight = 0;
+		StartWriting();
+		ShutdownIfWritten();
+	}
+
+	void ChromecastConnection::AsyncWrite(const CastMessage& message)
+	{
+		size_t message_size = message.GetEncodedSize();
+		endian::big_uint32_t packet_size = static_cast<uint32_t>(message_size);
+
+		//a handler running on the handler executor, the frame is encoded on its thread and queued on the strand.
+		if (!GetStrand().running_in_this_thread())
+		{
+			auto frame = std::make_shared<BufferPool::Buffer>(_buffer_pool.Acquire(sizeof(packet_size) + message_size));
+			memcpy((*frame)->data(), &packet_size, sizeof(packet_size));
+			message.Encode((*frame)->data() + sizeof(packet_size));
+			GetStrand().post([this, frame]()
+			{
+				if (_state != eConnectionState::Connected || _closing)
+					return;
+				memcpy(QueueFrame((*frame)->size()), (*frame)->data(), (*frame)->size());
+				StartWriting();
+			});
+			return;
+		}
+
+		//requests sent while the connection is down are retried by their channels once it is back.
+		if (_state != eConnectionState::Connected || _closing)
+			return;
+
+		//the frame is the big endian length followed by the message, both are encoded straight into the write queue.
+		byte* frame_data = QueueFrame(sizeof(packet_size) + message_size);
+		memcpy(frame_data, &packet_size, sizeof(packet_size));
+		message.Encode(frame_data + sizeof(packet_size));
+		StartWriting();
+	}
+
+	void ChromecastConnection::AsyncWrite(const EncodedFrame& frame)
+	{
+		if (!GetStrand().running_in_this_thread())
+		{
+			GetStrand().post([this, frame]()
+			{
+				AsyncWrite(frame);
+			});
+			return;
+		}
+
+		if (_state != eConnectionState::Connected || _closing)
+			return;
+
+		memcpy(QueueFrame(frame->size()), frame->data(), frame->size());
+		StartWriting();
+	}
+
+	const ChromecastConnection::WriteQueueStatistics& ChromecastConnection::GetWriteQueueStatistics() const
+	{
+		return _write_statistics;
+	}
+
+	void ChromecastConnection::Close()
+	{
+		//the state, the timer and the write queue belong to the strand, a frame posted before the close is queued before it.
+		if (!GetStrand().running_in_this_thread())
+		{
+			GetStrand().post([this]()
+			{
+				Close();
+			});
+			return;
+		}
+
+		_reconnect_timer.cancel();
+		if (_state == eConnectionState::Closed || _closing)
+			return;
+		if (_state != eConnectionState::Connected)
+		{
+			SetState(eConnectionState::Closed);
+			Abort();
+			return;
+		}
+
+		_closing = true;
+		ShutdownIfWritten();
+	}
+
+	void ChromecastConnection::ShutdownIfWritten()
+	{
+		//an ssl stream allows a single write operation at a time, async_shutdown writes the close notify.
+		if (!_closing || _write_in_flight || _pending_frames)
+			return;
+
+		_closing = false;
+		SetState(eConnectionState::Closed);
+		TLSConnection::Close();
+	}
+
+	void ChromecastConnection::SetState(eConnectionState state, const boost::system::error_code& error)
+	{
+		_state = state;
+		if (_on_state_changed)
+			_on_state_changed(state, error);
+	}
+
+	void ChromecastConnection::SetStateChangedCallback(const StateChangedCallback& callback)
+	{
+		_on_state_changed = callback;
+	}
+
+	ChromecastConnection::eConnectionState ChromecastConnection::GetState() const
+	{
+		return _state;
+	}
+
+	void ChromecastConnection::SetReconnectPolicy(const ReconnectPolicy& policy)
+	{
+		_reconnect_policy = policy;
+	}
+
+	void ChromecastConnection::SetReconnectedCallback(const ReconnectedCallback& callback)
+	{
+		_on_reconnected = callback;
+	}
+
+	void ChromecastConnection::OnConnectionLost(const boost::system::error_code& error)
+	{
+		if (_state != eConnectionState::Connected)
+			return;
+
+		Abort();
+		//a connection lost while it was closing is not reconnected.
+		if (!_reconnect_policy.enabled || _closing)
+		{
+			_closing = false;
+			SetState(eConnectionState::Closed, error);
+			return;
+		}
+
+		SetState(eConnectionState::Reconnecting, error);
+		//queued frames were meant for the lost connection, the in flight batch is released once its write completes.
+		_pending_frames.reset();
+		_write_statistics.queued_frames = 0;
+		_write_statistics.pending_bytes = 0;
+		_reconnect_attempt = 0;
+		ScheduleReconnect();
+	}
+
+	void ChromecastConnection::ScheduleReconnect()
+	{
+		if (_reconnect_policy.max_attempts != 0 && _reconnect_attempt >= _reconnect_policy.max_attempts)
+		{
+			SetState(eConnectionState::Closed, boost::asio::error::timed_out);
+			return;
+		}
+
+		double delay = _reconnect_policy.initial_delay_milliseconds * pow(_reconnect_policy.multiplier, static_cast<double>(_reconnect_attempt));
+		delay = (std::min)(delay, static_cast<double>(_reconnect_policy.max_delay_milliseconds));
+		std::uniform_real_distribution<double> jitter(1.0 - _reconnect_policy.jitter, 1.0);
+		delay *= jitter(_random);
+		++_reconnect_attempt;
+
+		_reconnect_timer.expires_from_now(boost::posix_time::milliseconds(static_cast<int64_t>(delay)));
+		_reconnect_timer.async_wait(GetStrand().wrap([=](const boost::system::error_code& error)
+		{
+			if (error || _state != eConnectionState::Reconnecting)
+				return;
+			AsyncReconnect(boost::bind(&ChromecastConnection::OnReconnectCompleted, this, boost::asio::placeholders::error));
+		}));
+	}
+
+	void ChromecastConnection::OnReconnectCompleted(const boost::system::error_code& error)
+	{
+		if (error)
+		{
+			if (_state == eConnectionState::Reconnecting)
+				ScheduleReconnect();
+			return;
+		}
+
+		if (_on_reconnected)
+			_on_reconnected();
+	}
+
+	void ChromecastConnection::SetMaxFrameSize(uint32_t max_frame_size)
+	{
+		//takes effect when the connection starts reading.
+		_max_frame_size = max_frame_size;
+	}
+
+	void ChromecastConnection::SetHandlerExecutor(boost::asio::io_service* executor)
+	{
+		_handler_executor = executor;
+	}
+
+	uint32_t ChromecastConnection::GetMaxFrameSize() const
+	{
+		return _max_frame_size;
+	}
+
+	BufferPool& ChromecastConnection::GetBufferPool()
+	{
+		return _buffer_pool;
+	}
+
+	ChromecastConnection::ChannelKey ChromecastConnection::GetChannelKey(const ChromecastChannel::Address& address, bool broadcast)
+	{
+		//the address of a channel names the sender as source, the source of a received message is the receiver the channel talks to.
+		ChannelKey key;
+		key.source = address._destination;
+		key.name_space = address._namespace;
+		if (!broadcast)
+			key.destination = address._source;
+		return key;
+	}
+
+	void ChromecastConnection::RemoveSubscription(boost::unordered_map<ChannelKey, Subscriptions>& key_to_subscriptions, const ChannelKey& key, const ChromecastChannel& channel, std::shared_ptr<Subscription>& removed)
+	{
+		auto it = key_to_subscriptions.find(key);
+		if (it == key_to_subscriptions.end())
+			return;
+
+		Subscriptions& subscriptions = it->second;
+		auto subscription = std::find_if(subscriptions.begin(), subscriptions.end(), [&](const std::shared_ptr<Subscription>& subscription)
+		{
+			return subscription->channel == &channel;
+		});
+		if (subscription == subscriptions.end())
+			return;
+
+		removed = *subscription;
+		subscriptions.erase(subscription);
+		if (subscriptions.empty())
+			key_to_subscriptions.erase(it);
+	}
+
+	void ChromecastConnection::RegisterChannel(ChromecastChannel& channel)
+	{
+		ChromecastChannel::Address address = channel.GetAddress();
+		auto subscription = std::make_shared<Subscription>(&channel);
+
+		lock_guard<mutex> lock(_registry_mutex);
+		auto registry = std::make_shared<ChannelRegistry>(*_registry);
+		registry->key_to_subscriptions[GetChannelKey(address, false)].push_back(subscription);
+		registry->broadcast_key_to_subscriptions[GetChannelKey(address, true)].push_back(subscription);
+		std::atomic_store(&_registry, std::shared_ptr<const ChannelRegistry>(std::move(registry)));
+	}
+
+	void ChromecastConnection::UnregisterChannel(const ChromecastChannel& channel)
+	{
+		ChromecastChannel::Address address = channel.GetAddress();
+		std::shared_ptr<Subscription> subscription;
+		{
+			lock_guard<mutex> lock(_registry_mutex);
+			auto registry = std::make_shared<ChannelRegistry>(*_registry);
+			RemoveSubscription(registry->key_to_subscriptions, GetChannelKey(address, false), channel, subscription);
+			THROW_ON_ERROR_EX(!subscription, "address " + address.ToString() + " not registered");
+			RemoveSubscription(registry->broadcast_key_to_subscriptions, GetChannelKey(address, true), channel, subscription);
+			std::atomic_store(&_registry, std::shared_ptr<const ChannelRegistry>(std::move(registry)));
+		}
+
+		//waits for a message the channel is handling on another thread, later dispatches of a snapshot or queue still holding the subscription skip it.
+		lock_guard<recursive_mutex> lock(subscription->handler_mutex);
+		subscription->registered = false;
+	}
 }
\ No newline at end of file
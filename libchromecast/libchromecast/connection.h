@@ -1,78 +1,297 @@
-#pragma once
-#include "types.h"
-#include "cast_message.h"
-#include "channel.h"
-#include "channel_factory.h"
-
-#include <memory>
-#include <boost\asio.hpp>
-#include <boost\endian\arithmetic.hpp>
-
-namespace chromecast
-{
-	struct TLSSocket;
-	class TLSConnection
-	{
-		typedef TLSConnection type;
-		// Type of a shared pointer to this connection socket component
-
-		typedef std::function<void(const boost::system::error_code& error)> RequestCompletedCallback;
-		typedef std::function<void(const boost::system::error_code& error, size_t bytes_transferred)> IORequestCompletedCallback;
-	private:
-		boost::noncopyable _non_copyable;
-
-		TLSSocket* _socket_impl;
-		RequestCompletedCallback _connection_callback;
-
-		void OnConnectCompleted(const boost::system::error_code& error);
-		void OnHandshake(const boost::system::error_code& error);
-		virtual void OnConnectionReady() { }
-
-	protected:
-		void AsyncRead(byte* buffer, size_t read_byte_count, const IORequestCompletedCallback& read_completed);
-
-	public:
-		TLSConnection(boost::asio::io_service& io_service);
-		virtual ~TLSConnection();
-
-		bool AsyncConnect(std::string ip, uint16_t port, const RequestCompletedCallback& callback);
-		void AsyncConnect(const  boost::asio::ip::tcp::endpoint& end_point, const RequestCompletedCallback& callback);
-		void Close();
-
-		void EnsureConnectionIsAlive();
-		void AsyncWrite(boost::asio::streambuf& buffer, const IORequestCompletedCallback& write_completed);
-	};
-
-	class ChromecastConnection : protected TLSConnection 
-	{
-		struct CastPacket
-		{
-			boost::endian::big_uint32_t length;
-			std::unique_ptr<byte[]> data;
-		};
-		CastPacket _current_packet;
-		std::map<ChromecastChannel::Address, ChromecastChannel*> _channel_address_to_channel;
-
-		void OnConnectionReady() override;
-
-		void OnMessage(const CastMessage& message);
-		void StartReadingPacketLength();
-		void StartReadingData(uint32_t remaining_data_byte_count);
-		void StartReading(byte* buffer, uint32_t buffer_size, const std::function<void()>& completed_reading);
-	protected:
-		virtual void OnUnrecognizedAddress(const CastMessage& message);
-	public:
-		ChromecastConnection(boost::asio::io_service& io_service);
-		~ChromecastConnection();
-
-		ChromecastChannelFactory channel_factory;
-
-		using TLSConnection::AsyncConnect;
-		using TLSConnection::Close;
-
-		void AsyncWrite(CastMessage& message);
-
-		void RegisterChannel(ChromecastChannel& channel);
-		void UnregisterChannel(const ChromecastChannel& channel);
-	};
+#pragma once
+#include "types.h"
+#include "cast_message.h"
+#include "channel.h"
+#include "channel_factory.h"
+#include "buffer_pool.h"
+#include "tls_context.h"
+#include "atom_table.h"
+
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <vector>
+#include <boost\asio.hpp>
+#include <boost\unordered_map.hpp>
+#include <boost\functional\hash.hpp>
+#include <boost\endian\arithmetic.hpp>
+
+namespace chromecast
+{
+	struct TLSSocket;
+	class TLSConnection
+	{
+		typedef TLSConnection type;
+		// Type of a shared pointer to this connection socket component
+
+		typedef std::function<void(const boost::system::error_code& error)> RequestCompletedCallback;
+		typedef std::function<void(const boost::system::error_code& error, size_t bytes_transferred)> IORequestCompletedCallback;
+	public:
+		static const uint32_t k_default_connect_timeout_milliseconds = 10 * 1000;
+		static const uint32_t k_default_connect_stagger_milliseconds = 250;
+	private:
+		struct ConnectOperation;
+
+		boost::noncopyable _non_copyable;
+
+		boost::asio::io_service& _io_service;
+		boost::asio::io_service::strand _strand;
+		TLSContext& _tls_context;
+		//pending operations hold a reference to the socket they were started on, so a replaced socket outlives its completions.
+		std::shared_ptr<TLSSocket> _socket_impl;
+		boost::asio::ip::tcp::endpoint _end_point;
+		std::string _host;
+		uint16_t _port = 0;
+		uint32_t _connect_timeout_milliseconds = k_default_connect_timeout_milliseconds;
+		uint32_t _connect_stagger_milliseconds = k_default_connect_stagger_milliseconds;
+		std::shared_ptr<ConnectOperation> _connect_operation;
+
+		std::shared_ptr<ConnectOperation> StartConnectOperation(const RequestCompletedCallback& callback);
+		void Resolve(std::shared_ptr<ConnectOperation> operation);
+		void OnResolved(std::shared_ptr<ConnectOperation> operation, const boost::system::error_code& error, boost::asio::ip::tcp::resolver::iterator it);
+		void StartNextAttempt(std::shared_ptr<ConnectOperation> operation);
+		void ScheduleNextAttempt(std::shared_ptr<ConnectOperation> operation);
+		void OnAttemptConnected(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error);
+		void OnAttemptHandshake(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error);
+		void OnAttemptFailed(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::system::error_code& error);
+		void CancelConnectOperation(std::shared_ptr<ConnectOperation> operation, const boost::system::error_code& error);
+		void CompleteConnectOperation(std::shared_ptr<ConnectOperation> operation, std::shared_ptr<TLSSocket> socket, const boost::asio::ip::tcp::endpoint& end_point, const boost::system::error_code& error);
+		virtual void OnConnectionReady() { }
+
+	protected:
+		void AsyncReadSome(byte* buffer, size_t max_read_byte_count, const IORequestCompletedCallback& read_completed);
+		//closes the socket without the ssl shutdown exchange and cancels a pending connect, pending operations complete with operation_aborted.
+		void Abort();
+		//connects to the endpoint of the last connection again, when it was given by name the freshly resolved addresses are raced against it.
+		void AsyncReconnect(const RequestCompletedCallback& callback);
+
+	public:
+		TLSConnection(boost::asio::io_service& io_service, TLSContext& tls_context = TLSContext::GetDefault());
+		virtual ~TLSConnection();
+
+		//the host is either an address or a name that is resolved asynchronously, returns false for an empty host.
+		bool AsyncConnect(std::string host, uint16_t port, const RequestCompletedCallback& callback);
+		void AsyncConnect(const  boost::asio::ip::tcp::endpoint& end_point, const RequestCompletedCallback& callback);
+		//the attempts are started one stagger interval apart, or as soon as the previous one failed, the first completed handshake wins and the others are closed.
+		void AsyncConnect(const std::vector<boost::asio::ip::tcp::endpoint>& end_points, const RequestCompletedCallback& callback);
+
+		//bounds resolution, connect and handshake together, the callback is called with timed_out when it expires. zero disables the deadline.
+		void SetConnectTimeout(uint32_t timeout_milliseconds);
+		uint32_t GetConnectTimeout() const;
+		void SetConnectStagger(uint32_t stagger_milliseconds);
+		//starts the ssl shutdown exchange, the socket is closed once it completed without blocking the calling thread.
+		void Close();
+
+		void AsyncWrite(const byte* buffer, size_t write_byte_count, const IORequestCompletedCallback& write_completed);
+
+		//every completion handler of the connection runs through this strand, so a connection can be driven by several io_service threads.
+		//operations started from outside of a connection handler should be posted to it.
+		boost::asio::io_service::strand& GetStrand();
+	};
+
+	class ChromecastConnection : protected TLSConnection 
+	{
+	public:
+		enum class eConnectionState
+		{
+			Disconnected,
+			Connected,
+			Reconnecting,
+			Closed
+		};
+
+		//reconnecting is opt in, the delay before attempt n is min(initial_delay * multiplier^n, max_delay) reduced by a random part of up to jitter of it.
+		struct ReconnectPolicy
+		{
+			bool enabled = false;
+			uint32_t initial_delay_milliseconds = 100;
+			uint32_t max_delay_milliseconds = 30 * 1000;
+			double multiplier = 2;
+			double jitter = 0.5;
+			//zero keeps trying until the connection is closed.
+			uint32_t max_attempts = 0;
+		};
+
+		typedef std::function<void()> ReconnectedCallback;
+		typedef std::function<void(eConnectionState state, const boost::system::error_code& error)> StateChangedCallback;
+
+		struct WriteQueueStatistics
+		{
+			size_t queued_frames = 0;
+			size_t pending_bytes = 0;
+			size_t in_flight_bytes = 0;
+			uint64_t frames_written = 0;
+			uint64_t bytes_written = 0;
+			uint64_t writes_issued = 0;
+		};
+	private:
+		BufferPool& _buffer_pool;
+		uint32_t _max_frame_size;
+
+		//received bytes are kept in [_read_begin, _read_end) of the read buffer, a partial frame at the tail is moved to the front before the next read.
+		BufferPool::Buffer _read_buffer;
+		size_t _read_begin = 0;
+		size_t _read_end = 0;
+
+		//frames queued while a write is in flight are encoded back to back into _pending_frames and sent together by the next write.
+		BufferPool::Buffer _write_in_flight;
+		BufferPool::Buffer _pending_frames;
+		size_t _frames_in_flight = 0;
+		WriteQueueStatistics _write_statistics;
+
+		//a channel address as seen from the receiving side, the broadcast index uses it with no destination.
+		//the atoms are not referenced by the key, the address of the registered channel keeps them alive.
+		struct ChannelKey
+		{
+			Atom source = AtomTable::k_no_atom;
+			Atom destination = AtomTable::k_no_atom;
+			Atom name_space = AtomTable::k_no_atom;
+
+			bool operator==(const ChannelKey& other) const
+			{
+				return source == other.source && destination == other.destination && name_space == other.name_space;
+			}
+
+			friend size_t hash_value(const ChannelKey& key)
+			{
+				size_t seed = 0;
+				boost::hash_combine(seed, key.source);
+				boost::hash_combine(seed, key.destination);
+				boost::hash_combine(seed, key.name_space);
+				return seed;
+			}
+		};
+
+		//a received message copied out of the read buffer, so it can be handled after the next read.
+		struct ReceivedMessage
+		{
+			BufferPool::Buffer encoded_message;
+			CastMessageView message;
+		};
+
+		struct Subscription
+		{
+			ChromecastChannel* channel;
+			bool handled_on_strand;
+			//held while the channel handles a message, unregistering takes it so the channel is not called anymore once it returned.
+			//recursive since a channel may unregister itself or another channel of its address from a handler.
+			std::recursive_mutex handler_mutex;
+			bool registered;
+
+			//the messages waiting for the handler executor, at most one of them is handled at a time so the channel sees them in order.
+			std::mutex queue_mutex;
+			std::deque<std::shared_ptr<ReceivedMessage>> queue;
+			bool queue_scheduled;
+
+			Subscription(ChromecastChannel* channel)
+				: channel(channel),
+				handled_on_strand(channel->IsHandledOnStrand()),
+				registered(true),
+				queue_scheduled(false)
+			{
+			}
+		};
+		typedef std::vector<std::shared_ptr<Subscription>> Subscriptions;
+
+		//the channels of every address in registration order, and the channels a message sent to "*" by a source on a namespace is delivered to.
+		struct ChannelRegistry
+		{
+			boost::unordered_map<ChannelKey, Subscriptions> key_to_subscriptions;
+			boost::unordered_map<ChannelKey, Subscriptions> broadcast_key_to_subscriptions;
+		};
+
+		AtomCache _atom_cache;
+		//registering copies the registry and publishes the copy, a dispatch loads the current snapshot and never takes the lock.
+		std::mutex _registry_mutex;
+		std::shared_ptr<const ChannelRegistry> _registry;
+
+		boost::asio::io_service* _handler_executor = nullptr;
+
+		void DispatchToSubscriptions(const Subscriptions& subscriptions, const CastMessageView& message, const byte* encoded_message, size_t encoded_message_size);
+		static void HandleMessage(Subscription& subscription, const CastMessageView& message);
+		static void ScheduleQueuedMessage(boost::asio::io_service& executor, std::shared_ptr<Subscription> subscription);
+		static void HandleQueuedMessage(boost::asio::io_service& executor, std::shared_ptr<Subscription> subscription);
+		static void RemoveSubscription(boost::unordered_map<ChannelKey, Subscriptions>& key_to_subscriptions, const ChannelKey& key, const ChromecastChannel& channel, std::shared_ptr<Subscription>& removed);
+		static ChannelKey GetChannelKey(const ChromecastChannel::Address& address, bool broadcast);
+
+		eConnectionState _state = eConnectionState::Disconnected;
+		//set by Close while the queued frames are still being written, the ssl shutdown starts once the write queue drained.
+		bool _closing = false;
+		//incremented on every established connection, completions of operations started on an earlier socket are recognized by it.
+		uint32_t _connection_generation = 0;
+		ReconnectPolicy _reconnect_policy;
+		ReconnectedCallback _on_reconnected;
+		StateChangedCallback _on_state_changed;
+		boost::asio::deadline_timer _reconnect_timer;
+		uint32_t _reconnect_attempt = 0;
+		std::mt19937 _random;
+
+		void OnConnectionReady() override;
+
+		byte* QueueFrame(size_t frame_size);
+		void StartWriting();
+		void OnWriteCompleted(uint32_t connection_generation, const boost::system::error_code& error, size_t bytes_transferred);
+		void ShutdownIfWritten();
+
+		void OnMessage(const CastMessageView& message, const byte* encoded_message, size_t encoded_message_size);
+		void StartReading();
+		void OnDataRead(uint32_t connection_generation, const boost::system::error_code& error, size_t bytes_transferred);
+		void DispatchFrames();
+
+		void SetState(eConnectionState state, const boost::system::error_code& error = boost::system::error_code());
+		void ScheduleReconnect();
+		void OnReconnectCompleted(const boost::system::error_code& error);
+	protected:
+		virtual void OnUnrecognizedAddress(const CastMessageView& message);
+	public:
+		ChromecastConnection(boost::asio::io_service& io_service, TLSContext& tls_context = TLSContext::GetDefault());
+		~ChromecastConnection();
+
+		ChromecastChannelFactory channel_factory;
+
+		using TLSConnection::AsyncConnect;
+		using TLSConnection::SetConnectTimeout;
+		using TLSConnection::GetConnectTimeout;
+		using TLSConnection::SetConnectStagger;
+		using TLSConnection::GetStrand;
+
+		//frames queued before the close are written first, the ssl shutdown never runs next to a write. safe to call from any thread.
+		void Close();
+		eConnectionState GetState() const;
+
+		void SetReconnectPolicy(const ReconnectPolicy& policy);
+		//called once a lost connection was established again, the channels are still registered but the virtual connections have to be reopened.
+		void SetReconnectedCallback(const ReconnectedCallback& callback);
+		//reports every state change together with the error that caused it, read and write errors never throw out of the io_service.
+		//a message that cannot be handled still throws out of the handler that received it, see OnUnrecognizedAddress and ChromecastChannel::OnUnhandledMessage.
+		void SetStateChangedCallback(const StateChangedCallback& callback);
+		//reconnects according to the reconnect policy, closes the connection when reconnecting is disabled.
+		void OnConnectionLost(const boost::system::error_code& error = boost::system::error_code());
+
+		//the cast protocol limits a message to 64KiB, frames announcing a larger length are rejected before anything is allocated for them.
+		static const uint32_t k_default_max_frame_size = 64 * 1024;
+
+		void AsyncWrite(const CastMessage& message);
+		//queues a frame encoded beforehand, it is only copied into the write queue.
+		void AsyncWrite(const EncodedFrame& frame);
+		const WriteQueueStatistics& GetWriteQueueStatistics() const;
+
+		//hands the messages of channels to an io_service run by a pool of worker threads instead of handling them on the strand that read them,
+		//so a slow handler does not hold up the connections sharing its thread. every channel still handles its messages one at a time and in order,
+		//channels that are handled on the strand stay there. handlers may send, everything else a handler shares with other threads has to be synchronized.
+		//set it before connecting, nullptr handles every message on the strand again.
+		void SetHandlerExecutor(boost::asio::io_service* executor);
+
+		void SetMaxFrameSize(uint32_t max_frame_size);
+		uint32_t GetMaxFrameSize() const;
+		BufferPool& GetBufferPool();
+
+		//any number of channels may share an address, messages are delivered to them in registration order.
+		//both are safe to call from any thread, unregistering waits for a message the channel is handling on another thread.
+		//channels call them from ChromecastChannel::Attach and Detach, never from their constructor or destructor.
+		void RegisterChannel(ChromecastChannel& channel);
+		void UnregisterChannel(const ChromecastChannel& channel);
+	};
 }
\ No newline at end of file
@@ -1,27 +1,26 @@
-#include "connection_channel.h"
-#include "json_message.h"
-
-namespace chromecast
-{
-	static const std::string k_connection_namespace = "urn:x-cast:com.google.cast.tp.connection";
-
-	ConnectionChannel::ConnectionChannel(ChromecastConnection& connection, const std::string& sender, const std::string& receiver)
-		: ChromecastChannel(connection, ChromecastChannel::Address(sender, receiver, k_connection_namespace))
-	{
-
-	}
-
-	void ConnectionChannel::Connect()
-	{
-		JsonMessage message;
-		message["type"] = "CONNECT";
-		Send(message.ToString());
-	}
-
-	void ConnectionChannel::Close()
-	{
-		JsonMessage message;
-		message["type"] = "CLOSE";
-		Send(message.ToString());
-	}
+#include "connection_channel.h"
+
+namespace chromecast
+{
+	static const std::string k_connection_namespace = "urn:x-cast:com.google.cast.tp.connection";
+	static const std::string k_connect_message = R"({"type":"CONNECT"})";
+	static const std::string k_close_message = R"({"type":"CLOSE"})";
+
+	ConnectionChannel::ConnectionChannel(ChromecastConnection& connection, const std::string& sender, const std::string& receiver)
+		: ChromecastChannel(connection, ChromecastChannel::Address(sender, receiver, k_connection_namespace), true),
+		_connect_frame(EncodeFrame(k_connect_message)),
+		_close_frame(EncodeFrame(k_close_message))
+	{
+
+	}
+
+	void ConnectionChannel::Connect()
+	{
+		Send(_connect_frame);
+	}
+
+	void ConnectionChannel::Close()
+	{
+		Send(_close_frame);
+	}
 }
\ No newline at end of file
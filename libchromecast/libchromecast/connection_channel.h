@@ -1,14 +1,16 @@
-#pragma once
-#include "channel.h"
-
-namespace chromecast
-{
-	class ConnectionChannel : public ChromecastChannel
-	{
-	public:
-		ConnectionChannel(ChromecastConnection& connection, const std::string& sender, const std::string& receiver);
-
-		void Connect();
-		void Close();
-	};
+#pragma once
+#include "channel.h"
+
+namespace chromecast
+{
+	class ConnectionChannel : public ChromecastChannel
+	{
+		EncodedFrame _connect_frame;
+		EncodedFrame _close_frame;
+	public:
+		ConnectionChannel(ChromecastConnection& connection, const std::string& sender, const std::string& receiver);
+
+		void Connect();
+		void Close();
+	};
 }
\ No newline at end of file
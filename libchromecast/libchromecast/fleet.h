@@ -0,0 +1,285 @@
+#pragma once
+#include "client.h"
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <memory>
+#include <boost\noncopyable.hpp>
+#include <boost\asio\deadline_timer.hpp>
+
+namespace chromecast
+{
+	//runs many chromecast clients on one io_service driven by a pool of worker threads, each client is serialized by the strand of its connection.
+	template <typename TClient = ChromecastClient<>>
+	class ChromecastFleet
+	{
+	public:
+		typedef std::map<std::string, bool> DeviceResults;
+		typedef std::map<std::string, ReceiverStatus> DeviceStatuses;
+		typedef std::function<void(const DeviceResults&)> BulkOperationCallback;
+		typedef std::function<void(const DeviceStatuses&)> BulkStatusCallback;
+		typedef std::function<void(const std::exception&)> WorkerErrorCallback;
+
+	private:
+		//collects the per device results of a bulk operation and reports them once every device completed or failed.
+		//only the first outcome of a device counts, a device answering after its deadline passed is ignored.
+		template <typename TResult>
+		class BulkOperation
+		{
+			std::mutex _mutex;
+			size_t _remaining;
+			std::set<std::string> _completed_devices;
+			std::map<std::string, TResult> _results;
+			//reported for a failed device, a failed device is left out of the results when there is none.
+			std::unique_ptr<TResult> _failure_result;
+			std::function<void(const std::map<std::string, TResult>&)> _callback;
+
+			void Complete(const std::string& device, const TResult* result)
+			{
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (!_completed_devices.insert(device).second)
+						return;
+					if (result)
+						_results.insert(std::make_pair(device, *result));
+					if (--_remaining != 0)
+						return;
+				}
+				if (_callback)
+					_callback(_results);
+			}
+		public:
+			BulkOperation(size_t device_count, const std::function<void(const std::map<std::string, TResult>&)>& callback, std::unique_ptr<TResult> failure_result)
+				: _remaining(device_count),
+				_failure_result(std::move(failure_result)),
+				_callback(callback)
+			{
+			}
+
+			void Complete(const std::string& device, const TResult& result)
+			{
+				Complete(device, &result);
+			}
+
+			void Fail(const std::string& device)
+			{
+				Complete(device, _failure_result.get());
+			}
+		};
+
+		boost::noncopyable _non_copyable;
+		boost::asio::io_service _io_service;
+		std::unique_ptr<boost::asio::io_service::work> _work;
+		std::vector<std::thread> _workers;
+		WorkerErrorCallback _on_worker_error;
+		uint32_t _operation_timeout_milliseconds = 10000;
+
+		std::mutex _mutex;
+		std::map<std::string, std::shared_ptr<TClient>> _device_to_client;
+
+		void RunWorker()
+		{
+			for (;;)
+			{
+				try
+				{
+					_io_service.run();
+					return;
+				}
+				catch (std::exception& e)
+				{
+					//one failing device must not take down the thread serving the rest of the fleet.
+					if (_on_worker_error)
+						_on_worker_error(e);
+				}
+			}
+		}
+
+		std::map<std::string, std::shared_ptr<TClient>> GetClients()
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			return _device_to_client;
+		}
+
+		//a device whose operation did not complete within timeout_milliseconds of the call fails, 0 waits for every device.
+		template <typename TResult, typename TOperation>
+		void ForEachClient(const std::function<void(const std::map<std::string, TResult>&)>& callback, uint32_t timeout_milliseconds, std::unique_ptr<TResult> failure_result, const TOperation& operation)
+		{
+			auto clients = GetClients();
+			if (clients.empty())
+			{
+				if (callback)
+					callback(std::map<std::string, TResult>());
+				return;
+			}
+
+			auto bulk_operation = std::make_shared<BulkOperation<TResult>>(clients.size(), callback, std::move(failure_result));
+			for (auto& device_to_client : clients)
+			{
+				std::string device = device_to_client.first;
+				std::shared_ptr<TClient> client = device_to_client.second;
+				boost::asio::io_service::strand* strand = &client->GetStrand();
+
+				//the deadline is waited on the client's strand, so completing the operation cancels it from there.
+				std::shared_ptr<boost::asio::deadline_timer> deadline;
+				if (timeout_milliseconds != 0)
+				{
+					deadline = std::make_shared<boost::asio::deadline_timer>(_io_service, boost::posix_time::milliseconds(timeout_milliseconds));
+					deadline->async_wait(strand->wrap([client, device, bulk_operation](const boost::system::error_code& error)
+					{
+						if (error != boost::asio::error::operation_aborted)
+							bulk_operation->Fail(device);
+					}));
+				}
+
+				//the completion handler may be kept by the client while the device does not answer, it must not own the client.
+				strand->post([=]()
+				{
+					operation(device, *client, [=](const TResult& result)
+					{
+						if (deadline)
+						{
+							strand->dispatch([deadline]()
+							{
+								boost::system::error_code error;
+								deadline->cancel(error);
+							});
+						}
+						bulk_operation->Complete(device, result);
+					});
+				});
+			}
+		}
+
+	public:
+		ChromecastFleet(size_t worker_count = std::thread::hardware_concurrency())
+		{
+			Start(worker_count);
+		}
+
+		~ChromecastFleet()
+		{
+			Stop();
+		}
+
+		void Start(size_t worker_count)
+		{
+			THROW_ON_ERROR_EX(!_workers.empty(), "fleet is already running");
+			if (worker_count == 0)
+				worker_count = 1;
+
+			_io_service.reset();
+			_work = std::make_unique<boost::asio::io_service::work>(_io_service);
+			for (size_t index = 0; index < worker_count; ++index)
+				_workers.emplace_back(&ChromecastFleet::RunWorker, this);
+		}
+
+		void Stop()
+		{
+			_work.reset();
+			_io_service.stop();
+			for (auto& worker : _workers)
+				worker.join();
+			_workers.clear();
+		}
+
+		void SetWorkerErrorCallback(const WorkerErrorCallback& callback)
+		{
+			_on_worker_error = callback;
+		}
+
+		//bounds LaunchAll and GetStatusAll per device, 0 waits until every device answered.
+		void SetOperationTimeout(uint32_t timeout_milliseconds)
+		{
+			_operation_timeout_milliseconds = timeout_milliseconds;
+		}
+
+		boost::asio::io_service& GetIOService()
+		{
+			return _io_service;
+		}
+
+		size_t GetWorkerCount() const
+		{
+			return _workers.size();
+		}
+
+		std::shared_ptr<TClient> Add(const std::string& device_ip)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto& client = _device_to_client[device_ip];
+			if (!client)
+				client = std::make_shared<TClient>(_io_service);
+			return client;
+		}
+
+		std::shared_ptr<TClient> Get(const std::string& device_ip)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			auto it = _device_to_client.find(device_ip);
+			return it != _device_to_client.end() ? it->second : nullptr;
+		}
+
+		//runs an operation on the strand of the device's connection.
+		template <typename TOperation>
+		void Post(const std::string& device_ip, const TOperation& operation)
+		{
+			auto client = Get(device_ip);
+			THROW_ON_ERROR_EX(!client, "unknown device " + device_ip);
+			client->GetStrand().post([=]()
+			{
+				operation(*client);
+			});
+		}
+
+		//every device connects at the same time, the callback is called once each of them connected or failed.
+		//the connect timeout of a device starts when its strand runs the connect, not at the call,
+		//so with busy workers the callback may come later than one connect timeout after the call.
+		void ConnectAll(const BulkOperationCallback& callback)
+		{
+			ForEachClient<bool>(callback, 0, nullptr, [](const std::string& device, TClient& client, const std::function<void(const bool&)>& completed)
+			{
+				client.AsyncConnect(device, [=](bool connected)
+				{
+					completed(connected);
+				});
+			});
+		}
+
+		//a device that did not launch before the operation timeout reports false.
+		void LaunchAll(const std::function<std::shared_ptr<SenderApplication>(const std::string&)>& create_application, const BulkOperationCallback& callback)
+		{
+			ForEachClient<bool>(callback, _operation_timeout_milliseconds, std::make_unique<bool>(false), [=](const std::string& device, TClient& client, const std::function<void(const bool&)>& completed)
+			{
+				client.Launch(create_application(device), [=](bool launched)
+				{
+					completed(launched);
+				});
+			});
+		}
+
+		//a device that did not answer before the operation timeout is left out of the statuses.
+		void GetStatusAll(const BulkStatusCallback& callback)
+		{
+			ForEachClient<ReceiverStatus>(callback, _operation_timeout_milliseconds, nullptr, [](const std::string& device, TClient& client, const std::function<void(const ReceiverStatus&)>& completed)
+			{
+				client.GetStatus([=](const ReceiverStatus& status)
+				{
+					completed(status);
+				});
+			});
+		}
+
+		void CloseAll(const BulkOperationCallback& callback)
+		{
+			ForEachClient<bool>(callback, 0, nullptr, [](const std::string& device, TClient& client, const std::function<void(const bool&)>& completed)
+			{
+				client.Close();
+				completed(true);
+			});
+		}
+	};
+}
@@ -1,69 +1,83 @@
-#include "heartbeat_channel.h"
-#include "json_message.h"
-#include "connection.h"
-#include "utils.h"
-
-namespace chromecast
-{
-	using namespace std;
-
-	static const std::string k_heartbeat_namespace = "urn:x-cast:com.google.cast.tp.heartbeat";
-
-	void HeartbeatChannel::StartSendTimer()
-	{
-		_heartbeat_send_timer.expires_from_now(boost::posix_time::seconds(send_interval_in_seconds));
-		_heartbeat_send_timer.async_wait([=](boost::system::error_code error)
-		{
-			THROW_ON_ERROR(error);
-
-			JsonMessage message;
-			message["type"] = "PING";
-			Send(message.ToString());
-			Start();
-		});
-	}
-
-	void HeartbeatChannel::StartReceiveTimer()
-	{
-		_heartbeat_receive_timer.cancel();
-		_heartbeat_receive_timer.expires_from_now(boost::posix_time::seconds(receive_timeout_in_seconds));
-		_heartbeat_receive_timer.async_wait([=](boost::system::error_code error)
-		{
-			if (!error)
-				_connection.Close();
-		});
-	}
-
-	HeartbeatChannel::HeartbeatChannel(boost::asio::io_service& io_service, ChromecastConnection& connection, const std::string& sender, const std::string& receiver)
-		: ChromecastChannel(connection, ChromecastChannel::Address(sender, receiver, k_heartbeat_namespace)),
-		_heartbeat_send_timer(io_service),
-		_heartbeat_receive_timer(io_service)
-	{
-
-	}
-
-	void HeartbeatChannel::Start()
-	{
-		StartSendTimer();
-		StartReceiveTimer();
-	}
-
-	bool HeartbeatChannel::OnMessage(const std::string& message)
-	{
-		JsonMessage json_message;
-		json_message.Parse(message);
-
-		std::string type = json_message["type"].GetString();
-		if (type == "PONG")
-			return true;
-		if (type != "PING")
-			return false;
-
-		JsonMessage pong_message;
-		pong_message["type"] = "PONG";
-		Send(pong_message.ToString());
-
-		StartReceiveTimer();
-		return true;
-	}
+#include "heartbeat_channel.h"
+#include "json_message.h"
+#include "connection.h"
+#include "utils.h"
+
+namespace chromecast
+{
+	using namespace std;
+
+	static const std::string k_heartbeat_namespace = "urn:x-cast:com.google.cast.tp.heartbeat";
+	static const std::string k_ping_message = R"({"type":"PING"})";
+	static const std::string k_pong_message = R"({"type":"PONG"})";
+
+	void HeartbeatChannel::StartSendTimer()
+	{
+		_heartbeat_send_timer.expires_from_now(boost::posix_time::seconds(send_interval_in_seconds));
+		_heartbeat_send_timer.async_wait(_connection.GetStrand().wrap([=](boost::system::error_code error)
+		{
+			//restarting the heartbeat after a reconnect cancels the pending wait.
+			if (error == boost::asio::error::operation_aborted || _connection.GetState() == ChromecastConnection::eConnectionState::Closed)
+				return;
+			if (error)
+				return _connection.OnConnectionLost(error);
+
+			Send(_ping_frame);
+			//only the answer may extend the receive timeout, otherwise a silent receiver would never be detected.
+			StartSendTimer();
+		}));
+	}
+
+	void HeartbeatChannel::StartReceiveTimer()
+	{
+		_heartbeat_receive_timer.cancel();
+		_heartbeat_receive_timer.expires_from_now(boost::posix_time::seconds(receive_timeout_in_seconds));
+		_heartbeat_receive_timer.async_wait(_connection.GetStrand().wrap([=](boost::system::error_code error)
+		{
+			if (!error)
+				_connection.OnConnectionLost();
+		}));
+	}
+
+	HeartbeatChannel::HeartbeatChannel(boost::asio::io_service& io_service, ChromecastConnection& connection, const std::string& sender, const std::string& receiver)
+		: ChromecastChannel(connection, ChromecastChannel::Address(sender, receiver, k_heartbeat_namespace), true),
+		_heartbeat_send_timer(io_service),
+		_heartbeat_receive_timer(io_service),
+		_ping_frame(EncodeFrame(k_ping_message)),
+		_pong_frame(EncodeFrame(k_pong_message))
+	{
+
+	}
+
+	void HeartbeatChannel::Start()
+	{
+		StartSendTimer();
+		StartReceiveTimer();
+	}
+
+	void HeartbeatChannel::Stop()
+	{
+		_heartbeat_send_timer.cancel();
+		_heartbeat_receive_timer.cancel();
+	}
+
+	bool HeartbeatChannel::OnTextMessage(const CastMessageView& message)
+	{
+		const JsonMessage& json_message = message.GetJson();
+
+		//our periodic PING is the liveness probe, either its PONG or a PING of the receiver proves the connection is alive.
+		std::string type = json_message["type"].GetString();
+		if (type == "PONG")
+		{
+			StartReceiveTimer();
+			return true;
+		}
+		if (type != "PING")
+			return false;
+
+		Send(_pong_frame);
+
+		StartReceiveTimer();
+		return true;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "json_arena.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <mutex>
+#include <boost\thread\tss.hpp>
+
+namespace chromecast
+{
+	using namespace std;
+
+	//zero initialized without a constructor call, so a hook set from the static initializer of another file is never overwritten.
+	static std::atomic<JsonHeapAllocator::AllocationHook> s_allocation_hook;
+
+	std::atomic<size_t> JsonArena::_default_chunk_size(JsonArena::k_default_chunk_size);
+
+	//never destroyed, a message released from a static object while the process exits may still ask for its thread's arena.
+	static boost::thread_specific_ptr<shared_ptr<JsonArena>>* s_thread_arena = nullptr;
+	static once_flag s_thread_arena_flag;
+
+	void JsonHeapAllocator::SetAllocationHook(AllocationHook hook)
+	{
+		s_allocation_hook = hook;
+	}
+
+	void* JsonHeapAllocator::Malloc(size_t size)
+	{
+		AllocationHook hook = s_allocation_hook.load(memory_order_relaxed);
+		if (hook)
+			hook(size);
+		return malloc(size);
+	}
+
+	void* JsonHeapAllocator::Realloc(void* original, size_t original_size, size_t new_size)
+	{
+		AllocationHook hook = s_allocation_hook.load(memory_order_relaxed);
+		if (hook && new_size > original_size)
+			hook(new_size);
+		return realloc(original, new_size);
+	}
+
+	void JsonHeapAllocator::Free(void* data)
+	{
+		free(data);
+	}
+
+	JsonArena::JsonArena(size_t chunk_size)
+		: _chunk_size(chunk_size)
+	{
+
+	}
+
+	JsonArena::~JsonArena()
+	{
+		while (_free_chunks)
+		{
+			ChunkHeader* next = _free_chunks->next;
+			JsonHeapAllocator::Free(_free_chunks);
+			_free_chunks = next;
+		}
+	}
+
+	shared_ptr<JsonArena> JsonArena::GetThreadArena()
+	{
+		//messages hold a reference to their arena, so one released after its thread exited still has the arena to return its chunks to.
+		call_once(s_thread_arena_flag, []()
+		{
+			s_thread_arena = new boost::thread_specific_ptr<shared_ptr<JsonArena>>();
+		});
+		boost::thread_specific_ptr<shared_ptr<JsonArena>>& thread_arena = *s_thread_arena;
+		if (!thread_arena.get())
+			thread_arena.reset(new shared_ptr<JsonArena>(make_shared<JsonArena>(_default_chunk_size.load())));
+		return *thread_arena;
+	}
+
+	void JsonArena::SetDefaultChunkSize(size_t chunk_size)
+	{
+		_default_chunk_size = chunk_size;
+	}
+
+	size_t JsonArena::GetChunkSize() const
+	{
+		return _chunk_size;
+	}
+
+	void* JsonArena::Malloc(size_t size)
+	{
+		{
+			lock_guard<mutex> lock(_mutex);
+			//the pools ask for chunks of their chunk size, only larger values ask for more so the first fit is usually the first chunk.
+			for (ChunkHeader** it = &_free_chunks; *it; it = &(*it)->next)
+			{
+				ChunkHeader* chunk = *it;
+				if (chunk->capacity < size)
+					continue;
+
+				*it = chunk->next;
+				_free_bytes -= chunk->capacity;
+				return chunk + 1;
+			}
+		}
+
+		size_t capacity = (max)(size, _chunk_size);
+		ChunkHeader* chunk = static_cast<ChunkHeader*>(JsonHeapAllocator::Malloc(sizeof(ChunkHeader) + capacity));
+		if (!chunk)
+			throw bad_alloc();
+		chunk->capacity = capacity;
+		return chunk + 1;
+	}
+
+	void* JsonArena::Realloc(void* original, size_t original_size, size_t new_size)
+	{
+		if (original && static_cast<ChunkHeader*>(original)[-1].capacity >= new_size)
+			return original;
+
+		void* data = Malloc(new_size);
+		if (original)
+		{
+			memcpy(data, original, (min)(original_size, new_size));
+			Free(original);
+		}
+		return data;
+	}
+
+	void JsonArena::Free(void* data)
+	{
+		if (!data)
+			return;
+
+		ChunkHeader* chunk = static_cast<ChunkHeader*>(data) - 1;
+		{
+			lock_guard<mutex> lock(_mutex);
+			if (_free_bytes + chunk->capacity <= k_max_free_bytes)
+			{
+				chunk->next = _free_chunks;
+				_free_chunks = chunk;
+				_free_bytes += chunk->capacity;
+				return;
+			}
+		}
+		JsonHeapAllocator::Free(chunk);
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "types.h"
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <boost\noncopyable.hpp>
+
+namespace chromecast
+{
+	//takes the heap memory of the json code from malloc, in place of rapidjson::CrtAllocator.
+	//every block is reported to the allocation hook, so the allocations rapidjson makes besides operator new can be counted.
+	class JsonHeapAllocator
+	{
+	public:
+		typedef void (*AllocationHook)(size_t size);
+
+		static const bool kNeedFree = true;
+
+		//called for every malloc and every growing realloc, nullptr when nobody counts.
+		static void SetAllocationHook(AllocationHook hook);
+
+		static void* Malloc(size_t size);
+		static void* Realloc(void* original, size_t original_size, size_t new_size);
+		static void Free(void* data);
+	};
+
+	//the base allocator of the json memory pools, chunks released by a pool are kept for the next message instead of being freed.
+	//a message may be released on another thread than the one that built it, so the free chunks are guarded by a mutex.
+	class JsonArena
+	{
+		struct ChunkHeader
+		{
+			size_t capacity;
+			ChunkHeader* next;
+		};
+
+		boost::noncopyable _non_copyable;
+		std::mutex _mutex;
+		ChunkHeader* _free_chunks = nullptr;
+		size_t _free_bytes = 0;
+		size_t _chunk_size;
+
+		static std::atomic<size_t> _default_chunk_size;
+	public:
+		static const size_t k_default_chunk_size = 16 * 1024;
+		//free chunks beyond this many bytes are freed.
+		static const size_t k_max_free_bytes = 1024 * 1024;
+
+		JsonArena(size_t chunk_size = k_default_chunk_size);
+		~JsonArena();
+
+		//the arena of the calling thread, created with the default chunk size on first use.
+		static std::shared_ptr<JsonArena> GetThreadArena();
+		//the chunk size of thread arenas created from now on.
+		static void SetDefaultChunkSize(size_t chunk_size);
+
+		size_t GetChunkSize() const;
+
+		void* Malloc(size_t size);
+		void* Realloc(void* original, size_t original_size, size_t new_size);
+		void Free(void* data);
+	};
+}
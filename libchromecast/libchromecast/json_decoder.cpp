@@ -0,0 +1,290 @@
+#include "json_decoder.h"
+#include "json_streams.h"
+#include "json_arena.h"
+#include "utils.h"
+
+#define RAPIDJSON_NO_INT64DEFINE
+
+#include <vector>
+#include <limits>
+#include <rapidjson\reader.h>
+
+namespace chromecast
+{
+	using namespace std;
+
+	bool JsonScalar::GetBool() const
+	{
+		THROW_ON_ERROR_EX(type != eType::Bool, "json value is not a bool");
+		return bool_value;
+	}
+
+	double JsonScalar::GetDouble() const
+	{
+		THROW_ON_ERROR_EX(type != eType::Integer && type != eType::Double, "json value is not a number");
+		if (type == eType::Double)
+			return double_value;
+		double value = static_cast<double>(integer_value);
+		return is_negative ? -value : value;
+	}
+
+	uint32_t JsonScalar::GetUint32() const
+	{
+		uint64_t value = GetUint64();
+		THROW_ON_ERROR_EX(value > (std::numeric_limits<uint32_t>::max)(), "json value does not fit an unsigned 32 bit integer");
+		return static_cast<uint32_t>(value);
+	}
+
+	uint64_t JsonScalar::GetUint64() const
+	{
+		THROW_ON_ERROR_EX(type != eType::Integer || is_negative, "json value is not an unsigned integer");
+		return integer_value;
+	}
+
+	std::string JsonScalar::GetString() const
+	{
+		THROW_ON_ERROR_EX(type != eType::String, "json value is not a string");
+		return string_value.to_string();
+	}
+
+	bool JsonScalar::Equals(const char* text) const
+	{
+		return type == eType::String && string_value == text;
+	}
+
+	//the handler of the reader, keeps the targets of the open objects and arrays.
+	//the handlers return bool for readers that can be stopped by a handler and names may also arrive through Key, the older reader ignores the result
+	//and passes names to String.
+	class JsonDecoderHandler
+	{
+		struct Scope
+		{
+			JsonDecoder::Target* target;
+			bool is_object;
+			bool expecting_name;
+		};
+
+		JsonDecoder::Target& _root;
+		std::vector<Scope> _scopes;
+		//the nesting depth inside a value no target wanted.
+		size_t _skipped_depth = 0;
+		//names are copied, the reader may reuse the memory of a string once the handler returned.
+		std::string _name;
+
+		boost::string_ref GetName(const Scope& scope) const
+		{
+			return scope.is_object ? boost::string_ref(_name) : boost::string_ref();
+		}
+
+		bool OnScalar(const JsonScalar& value)
+		{
+			if (_skipped_depth != 0 || _scopes.empty())
+				return true;
+
+			Scope& scope = _scopes.back();
+			scope.target->OnScalar(GetName(scope), value);
+			scope.expecting_name = scope.is_object;
+			return true;
+		}
+
+		bool OnStart(bool is_array)
+		{
+			if (_skipped_depth != 0)
+			{
+				++_skipped_depth;
+				return true;
+			}
+
+			JsonDecoder::Target* target = &_root;
+			if (!_scopes.empty())
+			{
+				Scope& parent = _scopes.back();
+				target = parent.target->OnNested(GetName(parent), is_array);
+				parent.expecting_name = parent.is_object;
+				if (!target)
+				{
+					_skipped_depth = 1;
+					return true;
+				}
+			}
+
+			Scope scope = { target, !is_array, !is_array };
+			_scopes.push_back(scope);
+			return true;
+		}
+
+		bool OnEnd()
+		{
+			if (_skipped_depth != 0)
+			{
+				--_skipped_depth;
+				return true;
+			}
+
+			_scopes.back().target->OnEnd();
+			_scopes.pop_back();
+			return true;
+		}
+
+		static JsonScalar Integer(uint64_t value, bool is_negative)
+		{
+			JsonScalar scalar;
+			scalar.type = JsonScalar::eType::Integer;
+			scalar.integer_value = value;
+			scalar.is_negative = is_negative;
+			return scalar;
+		}
+	public:
+		typedef char Ch;
+
+		JsonDecoderHandler(JsonDecoder::Target& root)
+			: _root(root)
+		{
+			_scopes.reserve(16);
+		}
+
+		bool Null()
+		{
+			return OnScalar(JsonScalar());
+		}
+
+		bool Bool(bool value)
+		{
+			JsonScalar scalar;
+			scalar.type = JsonScalar::eType::Bool;
+			scalar.bool_value = value;
+			return OnScalar(scalar);
+		}
+
+		bool Int(int value)
+		{
+			return Int64(value);
+		}
+
+		bool Uint(unsigned value)
+		{
+			return OnScalar(Integer(value, false));
+		}
+
+		bool Int64(int64_t value)
+		{
+			return OnScalar(value < 0 ? Integer(0 - static_cast<uint64_t>(value), true) : Integer(static_cast<uint64_t>(value), false));
+		}
+
+		bool Uint64(uint64_t value)
+		{
+			return OnScalar(Integer(value, false));
+		}
+
+		bool Double(double value)
+		{
+			JsonScalar scalar;
+			scalar.type = JsonScalar::eType::Double;
+			scalar.double_value = value;
+			return OnScalar(scalar);
+		}
+
+		bool String(const Ch* text, rapidjson::SizeType length, bool copy)
+		{
+			if (_skipped_depth == 0 && !_scopes.empty() && _scopes.back().expecting_name)
+				return Key(text, length, copy);
+
+			JsonScalar scalar;
+			scalar.type = JsonScalar::eType::String;
+			scalar.string_value = boost::string_ref(text, length);
+			return OnScalar(scalar);
+		}
+
+		bool Key(const Ch* text, rapidjson::SizeType length, bool copy)
+		{
+			if (_skipped_depth == 0)
+			{
+				_name.assign(text, length);
+				_scopes.back().expecting_name = false;
+			}
+			return true;
+		}
+
+		bool StartObject()
+		{
+			return OnStart(false);
+		}
+
+		bool EndObject(rapidjson::SizeType member_count = 0)
+		{
+			return OnEnd();
+		}
+
+		bool StartArray()
+		{
+			return OnStart(true);
+		}
+
+		bool EndArray(rapidjson::SizeType element_count = 0)
+		{
+			return OnEnd();
+		}
+	};
+
+	namespace
+	{
+		class JsonMessageHeaderTarget : public JsonDecoder::Target
+		{
+			JsonMessageHeader& _header;
+		public:
+			JsonMessageHeaderTarget(JsonMessageHeader& header)
+				: _header(header)
+			{
+
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				if (name == "type")
+					_header.type = value.GetString();
+				else if (name == "requestId")
+					_header.request_id = value.GetUint64();
+			}
+		};
+	}
+
+	JsonMessageHeader JsonMessageHeader::FromJson(const boost::string_ref& json)
+	{
+		JsonMessageHeader header;
+		JsonMessageHeaderTarget target(header);
+		JsonDecoder::Decode(json, target);
+		return header;
+	}
+
+	void JsonRequiredMembers::Reset()
+	{
+		_found = 0;
+	}
+
+	void JsonRequiredMembers::OnMember(const boost::string_ref& name)
+	{
+		for (size_t index = 0; index < _count; ++index)
+		{
+			if (name == _names[index])
+			{
+				_found |= uint64_t(1) << index;
+				return;
+			}
+		}
+	}
+
+	void JsonRequiredMembers::Check() const
+	{
+		for (size_t index = 0; index < _count; ++index)
+			THROW_ON_ERROR_EX(!(_found & (uint64_t(1) << index)), std::string("message does not have member ") + _names[index]);
+	}
+
+	void JsonDecoder::Decode(const boost::string_ref& json, Target& root)
+	{
+		JsonDecoderHandler handler(root);
+		BoundedStringStream stream(json.data(), json.size());
+		rapidjson::GenericReader<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<JsonHeapAllocator>> reader;
+		reader.Parse<rapidjson::kParseDefaultFlags>(stream, handler);
+		THROW_ON_ERROR_EX(reader.HasParseError(), "invalid json at offset " + to_string(reader.GetErrorOffset()));
+	}
+}
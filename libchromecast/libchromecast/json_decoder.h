@@ -0,0 +1,108 @@
+#pragma once
+#include "types.h"
+
+#include <string>
+#include <vector>
+#include <boost\utility\string_ref.hpp>
+
+namespace chromecast
+{
+	//a number, string, bool or null handed to a decoder target, a string only stays valid during the call.
+	struct JsonScalar
+	{
+		enum class eType
+		{
+			Null,
+			Bool,
+			Integer,
+			Double,
+			String
+		};
+
+		eType type = eType::Null;
+		bool bool_value = false;
+		bool is_negative = false;
+		uint64_t integer_value = 0;
+		double double_value = 0;
+		boost::string_ref string_value;
+
+		bool GetBool() const;
+		double GetDouble() const;
+		uint32_t GetUint32() const;
+		uint64_t GetUint64() const;
+		std::string GetString() const;
+		bool Equals(const char* text) const;
+	};
+
+	//fills typed structs from the events of a streaming json reader, no document is built on the way.
+	class JsonDecoder
+	{
+	public:
+		//receives the members of one object or the items of one array, items are passed with an empty name.
+		class Target
+		{
+		public:
+			virtual ~Target() { }
+
+			virtual void OnScalar(const boost::string_ref& name, const JsonScalar& value) { }
+			//returns the target of a nested object or array, nullptr skips the whole value.
+			virtual Target* OnNested(const boost::string_ref& name, bool is_array) { return nullptr; }
+			virtual void OnEnd() { }
+		};
+
+		//the root target receives the members of the root object, throws on invalid json.
+		static void Decode(const boost::string_ref& json, Target& root);
+	};
+
+	//the type and request id of a message, read without decoding any nested value.
+	struct JsonMessageHeader
+	{
+		std::string type;
+		uint64_t request_id = 0;
+
+		static JsonMessageHeader FromJson(const boost::string_ref& json);
+	};
+
+	//the members a target requires in its object, the target reports the names it receives and checks them once the object ended.
+	class JsonRequiredMembers
+	{
+		const char* const* _names;
+		size_t _count;
+		uint64_t _found = 0;
+	public:
+		template <size_t N>
+		JsonRequiredMembers(const char* const (&names)[N])
+			: _names(names),
+			_count(N)
+		{
+			static_assert(N <= 64, "too many required json members");
+		}
+
+		void Reset();
+		void OnMember(const boost::string_ref& name);
+		//throws for the first required member that was not received, as the field tables do for a document.
+		void Check() const;
+	};
+
+	//adds an item for every object of an array and hands it to a single reused item target, the item target is reset to each new item.
+	template <typename TItem, typename TItemTarget>
+	class JsonObjectArrayTarget : public JsonDecoder::Target
+	{
+		std::vector<TItem>* _items = nullptr;
+		TItemTarget _item_target;
+	public:
+		void Reset(std::vector<TItem>& items)
+		{
+			_items = &items;
+		}
+
+		JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+		{
+			if (is_array)
+				return nullptr;
+			_items->emplace_back();
+			_item_target.Reset(_items->back());
+			return &_item_target;
+		}
+	};
+}
@@ -0,0 +1,277 @@
+#pragma once
+#include "json_message.h"
+#include "json_writer.h"
+#include "utils.h"
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <initializer_list>
+#include <boost\utility\string_ref.hpp>
+
+namespace chromecast
+{
+	//reads a json value into a member and writes the member back to a message or a writer, specialized for the scalars, strings and vectors.
+	//any other type is converted through its own FromMessage and ToMessage.
+	template <typename T>
+	struct JsonConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, T& value)
+		{
+			value = T::FromMessage(part);
+		}
+
+		static void Write(JsonMessagePart& part, const T& value)
+		{
+			value.ToMessage(part);
+		}
+
+		static void Write(JsonWriter& writer, const T& value)
+		{
+			value.ToMessage(writer);
+		}
+	};
+
+	template <typename T>
+	struct JsonScalarConverter
+	{
+		static void Write(JsonMessagePart& part, const T& value)
+		{
+			part = value;
+		}
+
+		static void Write(JsonWriter& writer, const T& value)
+		{
+			writer.Value(value);
+		}
+	};
+
+	template <>
+	struct JsonConverter<bool> : JsonScalarConverter<bool>
+	{
+		static void Read(const ConstJsonMessagePart& part, bool& value) { value = part.GetBool(); }
+	};
+
+	template <>
+	struct JsonConverter<double> : JsonScalarConverter<double>
+	{
+		static void Read(const ConstJsonMessagePart& part, double& value) { value = part.GetDouble(); }
+	};
+
+	template <>
+	struct JsonConverter<uint32_t> : JsonScalarConverter<uint32_t>
+	{
+		static void Read(const ConstJsonMessagePart& part, uint32_t& value) { value = part.GetUint32(); }
+	};
+
+	template <>
+	struct JsonConverter<uint64_t> : JsonScalarConverter<uint64_t>
+	{
+		static void Read(const ConstJsonMessagePart& part, uint64_t& value) { value = part.GetUint64(); }
+	};
+
+	template <>
+	struct JsonConverter<std::string> : JsonScalarConverter<std::string>
+	{
+		static void Read(const ConstJsonMessagePart& part, std::string& value) { value = part.GetString(); }
+	};
+
+	template <typename T>
+	struct JsonConverter<std::vector<T>>
+	{
+		static void Read(const ConstJsonMessagePart& part, std::vector<T>& items)
+		{
+			items.resize(part.Size());
+			for (size_t index = 0; index < items.size(); ++index)
+				JsonConverter<T>::Read(part[index], items[index]);
+		}
+
+		static void Write(JsonMessagePart& part, const std::vector<T>& items)
+		{
+			part.Resize(items.size());
+			for (size_t index = 0; index < items.size(); ++index)
+			{
+				JsonMessagePart item = part[index];
+				JsonConverter<T>::Write(item, items[index]);
+			}
+		}
+
+		static void Write(JsonWriter& writer, const std::vector<T>& items)
+		{
+			writer.StartArray();
+			for (const T& item : items)
+				JsonConverter<T>::Write(writer, item);
+			writer.EndArray();
+		}
+	};
+
+	//the json fields of a struct, declared once with JSON_FIELD and used for both directions.
+	//reading walks the members of the object once and looks every name up in the table, instead of searching the object for every field.
+	//a field without write functions is only read, it is left out of the messages the struct writes.
+	template <typename TStruct>
+	class JsonFields
+	{
+	public:
+		struct Field
+		{
+			const char* name;
+			bool required;
+			void(*read)(const ConstJsonMessagePart& part, TStruct& value);
+			void(*write)(JsonMessagePart& part, const TStruct& value);
+			void(*write_json)(JsonWriter& writer, const TStruct& value);
+		};
+	private:
+		//fields are written in declaration order, the sorted indices are used to look a name up.
+		std::vector<Field> _fields;
+		std::vector<size_t> _sorted_indices;
+
+		size_t Find(const boost::string_ref& name) const
+		{
+			auto it = std::lower_bound(_sorted_indices.begin(), _sorted_indices.end(), name, [this](size_t index, const boost::string_ref& name)
+			{
+				return boost::string_ref(_fields[index].name) < name;
+			});
+			if (it == _sorted_indices.end() || name != _fields[*it].name)
+				return _fields.size();
+			return *it;
+		}
+	public:
+		JsonFields(std::initializer_list<Field> fields)
+			: _fields(fields)
+		{
+			THROW_ON_ERROR_EX(_fields.size() > 64, "too many json fields");
+			for (size_t index = 0; index < _fields.size(); ++index)
+				_sorted_indices.push_back(index);
+			std::sort(_sorted_indices.begin(), _sorted_indices.end(), [this](size_t left, size_t right)
+			{
+				return boost::string_ref(_fields[left].name) < boost::string_ref(_fields[right].name);
+			});
+		}
+
+		void Read(const ConstJsonMessagePart& message, TStruct& value) const
+		{
+			uint64_t found_fields = 0;
+			message.ForEachMember([&](const boost::string_ref& name, const ConstJsonMessagePart& member)
+			{
+				size_t index = Find(name);
+				if (index == _fields.size())
+					return;
+				found_fields |= uint64_t(1) << index;
+				_fields[index].read(member, value);
+			});
+
+			for (size_t index = 0; index < _fields.size(); ++index)
+				THROW_ON_ERROR_EX(_fields[index].required && !(found_fields & (uint64_t(1) << index)), std::string("message does not have member ") + _fields[index].name);
+		}
+
+		TStruct Read(const ConstJsonMessagePart& message) const
+		{
+			TStruct value;
+			Read(message, value);
+			return value;
+		}
+
+		void Write(const TStruct& value, JsonMessagePart& message) const
+		{
+			for (const Field& field : _fields)
+			{
+				if (!field.write)
+					continue;
+				JsonMessagePart part = message[field.name];
+				field.write(part, value);
+			}
+		}
+
+		void Write(const TStruct& value, JsonWriter& writer) const
+		{
+			writer.StartObject();
+			for (const Field& field : _fields)
+			{
+				if (!field.write_json)
+					continue;
+				writer.Key(field.name);
+				field.write_json(writer, value);
+			}
+			writer.EndObject();
+		}
+	};
+
+	//the member may belong to a base of the struct, so the member pointer type is a parameter of its own.
+	template <typename TStruct, typename TMemberPointer, TMemberPointer member, typename TConverter>
+	struct JsonFieldAccessor
+	{
+		static void Read(const ConstJsonMessagePart& part, TStruct& value)
+		{
+			TConverter::Read(part, value.*member);
+		}
+
+		static void Write(JsonMessagePart& part, const TStruct& value)
+		{
+			TConverter::Write(part, value.*member);
+		}
+
+		static void WriteJson(JsonWriter& writer, const TStruct& value)
+		{
+			TConverter::Write(writer, value.*member);
+		}
+	};
+
+	//a nested object of the message whose members are kept in the struct itself, the converter reads and writes the whole struct.
+	template <typename TStruct, typename TConverter>
+	struct JsonNestedAccessor
+	{
+		static void Read(const ConstJsonMessagePart& part, TStruct& value)
+		{
+			TConverter::Read(part, value);
+		}
+
+		static void Write(JsonMessagePart& part, const TStruct& value)
+		{
+			TConverter::Write(part, value);
+		}
+
+		static void WriteJson(JsonWriter& writer, const TStruct& value)
+		{
+			TConverter::Write(writer, value);
+		}
+	};
+
+	template <typename TStruct, typename TMemberPointer, TMemberPointer member, typename TConverter>
+	typename JsonFields<TStruct>::Field MakeJsonField(const char* name, bool required)
+	{
+		typedef JsonFieldAccessor<TStruct, TMemberPointer, member, TConverter> Accessor;
+		typename JsonFields<TStruct>::Field field = { name, required, &Accessor::Read, &Accessor::Write, &Accessor::WriteJson };
+		return field;
+	}
+
+	template <typename TStruct, typename TMemberPointer, TMemberPointer member, typename TConverter>
+	typename JsonFields<TStruct>::Field MakeJsonReadOnlyField(const char* name)
+	{
+		typedef JsonFieldAccessor<TStruct, TMemberPointer, member, TConverter> Accessor;
+		typename JsonFields<TStruct>::Field field = { name, false, &Accessor::Read, nullptr, nullptr };
+		return field;
+	}
+
+	template <typename TStruct, typename TConverter>
+	typename JsonFields<TStruct>::Field MakeJsonNestedField(const char* name, bool required)
+	{
+		typedef JsonNestedAccessor<TStruct, TConverter> Accessor;
+		typename JsonFields<TStruct>::Field field = { name, required, &Accessor::Read, &Accessor::Write, &Accessor::WriteJson };
+		return field;
+	}
+}
+
+#define JSON_FIELD_EX(struct_type, member, name, required, converter) \
+	chromecast::MakeJsonField<struct_type, decltype(&struct_type::member), &struct_type::member, converter>(name, required)
+#define JSON_FIELD(struct_type, member, name) \
+	JSON_FIELD_EX(struct_type, member, name, true, chromecast::JsonConverter<decltype(std::declval<struct_type>().member)>)
+#define JSON_OPTIONAL_FIELD(struct_type, member, name) \
+	JSON_FIELD_EX(struct_type, member, name, false, chromecast::JsonConverter<decltype(std::declval<struct_type>().member)>)
+//an optional field that is only read, such as a value the receiver reports and a sender never sends.
+#define JSON_READ_ONLY_FIELD(struct_type, member, name) \
+	chromecast::MakeJsonReadOnlyField<struct_type, decltype(&struct_type::member), &struct_type::member, \
+		chromecast::JsonConverter<decltype(std::declval<struct_type>().member)>>(name)
+//a nested object whose members the converter keeps in the struct itself.
+#define JSON_NESTED_FIELD(struct_type, name, required, converter) \
+	chromecast::MakeJsonNestedField<struct_type, converter>(name, required)
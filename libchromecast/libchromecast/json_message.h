@@ -1,92 +1,115 @@
-#pragma once
-#include "types.h"
-#include <rapidjson\document.h>
-
-#include <string>
-#include <vector>
-
-namespace chromecast
-{
-	class ConstJsonMessagePart
-	{
-	protected:
-		const rapidjson::Document::GenericValue& _value;
-	public:
-		ConstJsonMessagePart(const rapidjson::Document::GenericValue& value);
-		virtual ~ConstJsonMessagePart() { }
-
-		bool GetBool() const;
-		double GetDouble() const;
-		uint32_t GetUint32() const;
-		uint64_t GetUint64() const;
-		std::string GetString() const;
-
-		bool HasMember(const char* member) const;
-		std::string ToString() const;
-		size_t Size() const;
-
-		ConstJsonMessagePart operator[](const char* text) const;
-		ConstJsonMessagePart operator[](size_t index) const;
-	};
-
-	class JsonMessagePart : public ConstJsonMessagePart
-	{
-	protected:
-		rapidjson::Document::GenericValue& _value;
-		rapidjson::Document::AllocatorType& _allocator;
-	public:
-		JsonMessagePart(rapidjson::Document::GenericValue& value, rapidjson::Document::AllocatorType& allocator);
-
-		void operator=(bool value);
-		void operator=(double value);
-		void operator=(uint32_t value);
-		void operator=(uint64_t value);
-		void operator=(const char* text);
-		void operator=(const std::string& value);
-		void operator=(const std::vector<std::string>& items);
-
-		template <typename T>
-		typename std::enable_if<!std::is_pod<T>::value && !std::is_same<std::string, T>::value, void>::type operator=(const std::vector<T>& items)
-		{
-			_value.SetArray();
-			for (const auto& item : items)
-			{
-				_value.PushBack("", _allocator);
-				item.ToMessage(JsonMessagePart(_value[_value.Size() - 1], _allocator));
-			}
-		}
-
-		template <typename T>
-		typename std::enable_if<std::is_pod<T>::value && !std::is_same<std::string, T>::value, void>::type operator=(const std::vector<T>& items)
-		{
-			_value.SetArray();
-			for (const auto& item : items)
-			{
-				_value.PushBack("", _allocator);
-				JsonMessagePart(_value[_value.Size() - 1], _allocator) = item;
-			}
-		}
-
-		void Resize(size_t size);
-
-		JsonMessagePart operator[](const char* text);
-		JsonMessagePart operator[](size_t index);
-	};
-
-	class JsonMessage : public JsonMessagePart
-	{
-	protected:
-		rapidjson::Document::AllocatorType _allocator;
-		rapidjson::Document _document;
-	public:
-		JsonMessage();
-		JsonMessage(const JsonMessage& message);
-		virtual ~JsonMessage();
-
-		void Parse(const std::string& json_string);
-		std::string ToString() const;
-
-		JsonMessagePart operator[](const char* text);
-		const ConstJsonMessagePart operator[](const char* text) const;
-	};
+#pragma once
+#include "types.h"
+#include "json_arena.h"
+#include <rapidjson\document.h>
+#include <boost\utility\string_ref.hpp>
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace chromecast
+{
+	typedef rapidjson::MemoryPoolAllocator<JsonArena> JsonAllocator;
+	typedef rapidjson::GenericDocument<rapidjson::UTF8<>, JsonAllocator> JsonDocument;
+	typedef JsonDocument::ValueType JsonValue;
+
+	class ConstJsonMessagePart
+	{
+	protected:
+		const JsonValue& _value;
+	public:
+		ConstJsonMessagePart(const JsonValue& value);
+		virtual ~ConstJsonMessagePart() { }
+
+		bool GetBool() const;
+		double GetDouble() const;
+		uint32_t GetUint32() const;
+		uint64_t GetUint64() const;
+		std::string GetString() const;
+
+		bool HasMember(const char* member) const;
+		std::string ToString() const;
+		size_t Size() const;
+
+		ConstJsonMessagePart operator[](const char* text) const;
+		ConstJsonMessagePart operator[](size_t index) const;
+
+		//calls callback(name, value) for every member of an object, in one pass over the members.
+		template <typename TCallback>
+		void ForEachMember(TCallback callback) const
+		{
+			if (!_value.IsObject())
+				throw std::runtime_error("message is not an object");
+			for (auto it = _value.MemberBegin(); it != _value.MemberEnd(); ++it)
+				callback(boost::string_ref(it->name.GetString(), it->name.GetStringLength()), ConstJsonMessagePart(it->value));
+		}
+	};
+
+	class JsonMessagePart : public ConstJsonMessagePart
+	{
+	protected:
+		JsonValue& _value;
+		JsonAllocator& _allocator;
+	public:
+		JsonMessagePart(JsonValue& value, JsonAllocator& allocator);
+
+		void operator=(bool value);
+		void operator=(double value);
+		void operator=(uint32_t value);
+		void operator=(uint64_t value);
+		void operator=(const char* text);
+		void operator=(const std::string& value);
+		void operator=(const std::vector<std::string>& items);
+
+		template <typename T>
+		typename std::enable_if<!std::is_pod<T>::value && !std::is_same<std::string, T>::value, void>::type operator=(const std::vector<T>& items)
+		{
+			_value.SetArray();
+			for (const auto& item : items)
+			{
+				_value.PushBack("", _allocator);
+				item.ToMessage(JsonMessagePart(_value[_value.Size() - 1], _allocator));
+			}
+		}
+
+		template <typename T>
+		typename std::enable_if<std::is_pod<T>::value && !std::is_same<std::string, T>::value, void>::type operator=(const std::vector<T>& items)
+		{
+			_value.SetArray();
+			for (const auto& item : items)
+			{
+				_value.PushBack("", _allocator);
+				JsonMessagePart(_value[_value.Size() - 1], _allocator) = item;
+			}
+		}
+
+		void Resize(size_t size);
+
+		JsonMessagePart operator[](const char* text);
+		JsonMessagePart operator[](size_t index);
+	};
+
+	//the memory of a message comes from the arena of the thread that created it, or from the given one, and goes back to it once the message is destroyed.
+	class JsonMessage : public JsonMessagePart
+	{
+	protected:
+		std::shared_ptr<JsonArena> _arena;
+		JsonAllocator _allocator;
+		JsonDocument _document;
+	public:
+		JsonMessage();
+		explicit JsonMessage(const std::shared_ptr<JsonArena>& arena);
+		JsonMessage(const JsonMessage& message);
+		virtual ~JsonMessage();
+
+		void Parse(const std::string& json_string);
+		void Parse(const boost::string_ref& json_string);
+		//the strings of the document point into json_string instead of being copied, it is modified and has to outlive the message.
+		void ParseInsitu(char* json_string, size_t length);
+		std::string ToString() const;
+
+		JsonMessagePart operator[](const char* text);
+		const ConstJsonMessagePart operator[](const char* text) const;
+	};
 }
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+
+namespace chromecast
+{
+	//read only rapidjson input stream over a buffer that is not null terminated, such as a payload inside a received frame.
+	struct BoundedStringStream
+	{
+		typedef char Ch;
+
+		const Ch* _begin;
+		const Ch* _current;
+		const Ch* _end;
+
+		BoundedStringStream(const Ch* begin, size_t length)
+			: _begin(begin),
+			_current(begin),
+			_end(begin + length)
+		{
+		}
+
+		Ch Peek() const { return _current != _end ? *_current : '\0'; }
+		Ch Take() { return _current != _end ? *_current++ : '\0'; }
+		size_t Tell() const { return static_cast<size_t>(_current - _begin); }
+
+		Ch* PutBegin() { assert(false); return nullptr; }
+		void Put(Ch) { assert(false); }
+		void Flush() { assert(false); }
+		size_t PutEnd(Ch*) { assert(false); return 0; }
+	};
+
+	//the in situ counterpart, strings are unescaped over the text they were read from and terminated in place.
+	//the terminator of a string replaces its closing quote at the latest, so nothing is written beyond the buffer.
+	struct BoundedInsituStringStream : public BoundedStringStream
+	{
+		Ch* _destination = nullptr;
+
+		BoundedInsituStringStream(Ch* begin, size_t length)
+			: BoundedStringStream(begin, length)
+		{
+		}
+
+		Ch* PutBegin() { return _destination = const_cast<Ch*>(_current); }
+		void Put(Ch c) { assert(_destination != nullptr); *_destination++ = c; }
+		void Flush() { }
+		size_t PutEnd(Ch* begin) { return static_cast<size_t>(_destination - begin); }
+	};
+}
@@ -0,0 +1,97 @@
+#include "json_writer.h"
+
+#include <cstring>
+
+namespace chromecast
+{
+	JsonWriter::JsonWriter()
+		: _writer(_buffer)
+	{
+
+	}
+
+	JsonWriter& JsonWriter::StartObject()
+	{
+		_writer.StartObject();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::EndObject()
+	{
+		_writer.EndObject();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::StartArray()
+	{
+		_writer.StartArray();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::EndArray()
+	{
+		_writer.EndArray();
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Key(const boost::string_ref& name)
+	{
+		_writer.String(name.data(), static_cast<rapidjson::SizeType>(name.size()));
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(bool value)
+	{
+		_writer.Bool(value);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(double value)
+	{
+		_writer.Double(value);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(uint32_t value)
+	{
+		_writer.Uint(value);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(uint64_t value)
+	{
+		_writer.Uint64(value);
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(const char* text)
+	{
+		_writer.String(text, static_cast<rapidjson::SizeType>(strlen(text)));
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(const std::string& text)
+	{
+		_writer.String(text.c_str(), static_cast<rapidjson::SizeType>(text.size()));
+		return *this;
+	}
+
+	JsonWriter& JsonWriter::Value(const std::vector<std::string>& items)
+	{
+		_writer.StartArray();
+		for (const std::string& item : items)
+			Value(item);
+		_writer.EndArray();
+		return *this;
+	}
+
+	boost::string_ref JsonWriter::GetString() const
+	{
+		return boost::string_ref(_buffer.GetString(), _buffer.GetSize());
+	}
+
+	std::string JsonWriter::ToString() const
+	{
+		return GetString().to_string();
+	}
+}
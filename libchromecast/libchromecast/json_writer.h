@@ -0,0 +1,53 @@
+#pragma once
+#include "types.h"
+#include "json_arena.h"
+
+#include <string>
+#include <vector>
+#include <rapidjson\writer.h>
+#include <rapidjson\stringbuffer.h>
+#include <boost\noncopyable.hpp>
+#include <boost\utility\string_ref.hpp>
+
+namespace chromecast
+{
+	//the text buffers and writers of the json code, their memory comes from JsonHeapAllocator.
+	typedef rapidjson::GenericStringBuffer<rapidjson::UTF8<>, JsonHeapAllocator> JsonStringBuffer;
+	typedef rapidjson::Writer<JsonStringBuffer, rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<JsonHeapAllocator>> JsonTextWriter;
+
+	//serializes a message while it is being built, for outbound messages that never need to be read back.
+	//unlike JsonMessage no document is built, keys are written in the order they are given and are not checked for duplicates.
+	class JsonWriter
+	{
+		boost::noncopyable _non_copyable;
+		JsonStringBuffer _buffer;
+		JsonTextWriter _writer;
+	public:
+		JsonWriter();
+
+		JsonWriter& StartObject();
+		JsonWriter& EndObject();
+		JsonWriter& StartArray();
+		JsonWriter& EndArray();
+		JsonWriter& Key(const boost::string_ref& name);
+
+		JsonWriter& Value(bool value);
+		JsonWriter& Value(double value);
+		JsonWriter& Value(uint32_t value);
+		JsonWriter& Value(uint64_t value);
+		JsonWriter& Value(const char* text);
+		JsonWriter& Value(const std::string& text);
+		JsonWriter& Value(const std::vector<std::string>& items);
+
+		template <typename T>
+		JsonWriter& Member(const boost::string_ref& name, const T& value)
+		{
+			Key(name);
+			return Value(value);
+		}
+
+		//the text written so far, complete once every object and array was ended.
+		boost::string_ref GetString() const;
+		std::string ToString() const;
+	};
+}
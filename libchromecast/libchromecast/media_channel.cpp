@@ -1,98 +1,135 @@
-#include "json_message.h"
-#include "media_channel.h"
-
-namespace chromecast
-{
-	using namespace std;
-
-	static std::string GetMediaPlayerNamespace()
-	{
-		return "urn:x-cast:com.google.cast.media";
-	}
-
-	bool MediaChannel::OnResponse(uint64_t request_id, const JsonMessage& message)
-	{
-		if (message["type"].GetString() == "MEDIA_STATUS")
-			_last_status = MediaStatus::FromMessage(message);
-
-		if (request_id == 0)
-			return true;
-
-		return __super::OnResponse(request_id, message);
-	}
-
-	void MediaChannel::SessionRequest(JsonMessage&& message, const MediaOperationCallback& callback)
-	{
-		message["mediaSessionId"] = _last_status.session_id;
-		Request<MediaResponse>(move(message), [=](const MediaResponse& result)
-		{
-			if (callback)
-				callback(result);
-		});
-	}
-
-	MediaChannel::MediaChannel(boost::asio::io_service& io_service, ChromecastConnection& connection, const std::string& sender_id, const std::string& receiver_id)
-		: RequestChannel(io_service, connection, ChromecastChannel::Address(sender_id, receiver_id, GetMediaPlayerNamespace()))
-	{
-
-	}
-
-	void MediaChannel::Load(const Media& media, bool autoplay, const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "LOAD";
-		media.ToMessage(message);
-
-		Request<MediaResponse>(move(message), [=](const MediaResponse& result)
-		{
-			if (result.Succeeded())
-				_last_status = result.GetStatus();
-			if (callback)
-				callback(result);
-		});
-	}
-
-	void MediaChannel::Play(const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "PLAY";
-		SessionRequest(move(message), callback);
-	}
-
-	void MediaChannel::Pause(const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "PAUSE";
-		SessionRequest(move(message), callback);
-	}
-
-	void MediaChannel::Stop(const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "STOP";
-		SessionRequest(move(message), callback);
-	}
-
-	void MediaChannel::Seek(uint32_t minute_offset, const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "SEEK";
-		message["currentTime"] = minute_offset;
-		SessionRequest(move(message), callback);
-	}
-
-	void MediaChannel::SetTrackInfo(const std::vector<std::string>& track_ids, const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "EDIT_TRACKS_INFO";
-		message["activeTrackIds"] = track_ids;
-		SessionRequest(move(message), callback);
-	}
-
-	void MediaChannel::GetStatus(const MediaOperationCallback& callback)
-	{
-		JsonMessage message;
-		message["type"] = "GET_STATUS";
-		Request<MediaResponse>(move(message), callback);
-	}
+#include "json_message.h"
+#include "json_decoder.h"
+#include "media_channel.h"
+
+namespace chromecast
+{
+	using namespace std;
+
+	static std::string GetMediaPlayerNamespace()
+	{
+		return "urn:x-cast:com.google.cast.media";
+	}
+
+	bool MediaChannel::OnTextMessage(const CastMessageView& message)
+	{
+		//a status broadcast is decoded straight from the text when no other channel built a document for it.
+		//only the type and request id are read first, any other message goes through the document.
+		if (!message.HasJson())
+		{
+			JsonMessageHeader header = JsonMessageHeader::FromJson(message.payload_utf8);
+			if (header.type == "MEDIA_STATUS" && header.request_id == 0)
+			{
+				MediaStatus status = MediaStatus::FromJson(message.payload_utf8);
+				lock_guard<mutex> lock(_status_mutex);
+				_last_status = std::move(status);
+				return true;
+			}
+		}
+		return __super::OnTextMessage(message);
+	}
+
+	bool MediaChannel::OnResponse(uint64_t request_id, const JsonMessage& message)
+	{
+		if (message["type"].GetString() == "MEDIA_STATUS")
+		{
+			MediaStatus status = MediaStatus::FromMessage(message);
+			lock_guard<mutex> lock(_status_mutex);
+			_last_status = std::move(status);
+		}
+
+		if (request_id == 0)
+			return true;
+
+		return __super::OnResponse(request_id, message);
+	}
+
+	void MediaChannel::SessionRequest(JsonWriter& message, const MediaOperationCallback& callback)
+	{
+		{
+			lock_guard<mutex> lock(_status_mutex);
+			message.Member("mediaSessionId", _last_status.session_id);
+		}
+		Request<MediaResponse>(message, [=](const MediaResponse& result)
+		{
+			if (callback)
+				callback(result);
+		});
+	}
+
+	MediaChannel::MediaChannel(boost::asio::io_service& io_service, ChromecastConnection& connection, const std::string& sender_id, const std::string& receiver_id)
+		: RequestChannel(io_service, connection, ChromecastChannel::Address(sender_id, receiver_id, GetMediaPlayerNamespace()))
+	{
+
+	}
+
+	void MediaChannel::Load(const Media& media, bool autoplay, const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "LOAD");
+		message.Key("media");
+		media.ToMessage(message);
+
+		Request<MediaResponse>(message, [=](const MediaResponse& result)
+		{
+			if (result.Succeeded())
+			{
+				lock_guard<mutex> lock(_status_mutex);
+				_last_status = result.GetStatus();
+			}
+			if (callback)
+				callback(result);
+		});
+	}
+
+	void MediaChannel::Play(const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "PLAY");
+		SessionRequest(message, callback);
+	}
+
+	void MediaChannel::Pause(const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "PAUSE");
+		SessionRequest(message, callback);
+	}
+
+	void MediaChannel::Stop(const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "STOP");
+		SessionRequest(message, callback);
+	}
+
+	void MediaChannel::Seek(uint32_t minute_offset, const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "SEEK");
+		message.Member("currentTime", minute_offset);
+		SessionRequest(message, callback);
+	}
+
+	void MediaChannel::SetTrackInfo(const std::vector<std::string>& track_ids, const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "EDIT_TRACKS_INFO");
+		message.Member("activeTrackIds", track_ids);
+		SessionRequest(message, callback);
+	}
+
+	void MediaChannel::GetStatus(const MediaOperationCallback& callback)
+	{
+		JsonWriter message;
+		message.StartObject();
+		message.Member("type", "GET_STATUS");
+		Request<MediaResponse>(message, callback);
+	}
 }
\ No newline at end of file
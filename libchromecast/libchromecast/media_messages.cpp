@@ -1,292 +1,993 @@
-#include "media_messages.h"
-#include "json_message.h"
-#include "utils.h"
-#include <boost\lexical_cast.hpp>
-#include <map>
-
-namespace chromecast
-{
-	static std::map<std::string, MediaStatus::ePlayerState> player_json_state_to_state = 
-	{
-		{ "PLAYING", MediaStatus::ePlayerState::Playing },
-		{ "BUFFERING", MediaStatus::ePlayerState::Buffering },
-		{ "PAUSED", MediaStatus::ePlayerState::Paused },
-		{ "IDLE", MediaStatus::ePlayerState::Idle }
-	};
-
-	static std::map<std::string, MediaStatus::eRepeatMode> player_json_repeat_mode_to_repeat_mode =
-	{
-		{ "REPEAT_OFF", MediaStatus::eRepeatMode::Off },
-	};
-
-	void Media::Track::ToMessage(JsonMessagePart& message) const
-	{
-		message["trackId"] = id;
-		if (type == eTrackType::Text)
-			message["type"] = "TEXT";
-		else
-			THROW_ON_ERROR_EX(true, "unknown track type");
-
-		message["trackContentId"] = content_id;
-		message["trackContentType"] = content_type;
-		message["name"] = name;
-		message["language"] = language;
-		message["subtype"] = sub_type;
-	}
-
-	Media::Track Media::Track::FromMessage(const ConstJsonMessagePart& message)
-	{
-		eTrackType type = eTrackType::Text;
-		std::string track_type = message["type"].GetString();
-		if (track_type != "TEXT")
-			type = eTrackType::Unknown;
-
-		Track track;
-		track.id = message["trackId"].GetUint32();
-		track.type = type;
-		track.content_id = message["trackContentId"].GetString();
-		track.content_type = message["trackContentType"].GetString();
-		track.name = message["name"].GetString();
-		track.language = message["language"].GetString();
-		track.sub_type = message["subtype"].GetString();
-		return track;
-	}
-
-	Media::TextTrackStyle::Color Media::TextTrackStyle::Color::FromString(const std::string& value)
-	{
-		if (value.length() != 9)
-			throw std::runtime_error("invalid color value " + value);
-
-		if (value.front() != '#')
-			throw std::runtime_error("color value does not start with a # prefix" + value);
-
-		size_t pos = 1;
-		const size_t color_channel_string_length = 2;
-		Color color;
-		for (auto& b : color.value.argb)
-		{
-			b = boost::lexical_cast<byte>(value.substr(pos, color_channel_string_length));
-			pos += color_channel_string_length;
-		}
-		return color;
-	}
-
-	Media::TextTrackStyle::Edge Media::TextTrackStyle::Edge::FromMessage(const ConstJsonMessagePart& message)
-	{
-		eType type = eType::Outline;
-		std::string edge_type = message["edgeType"].GetString();
-		if (edge_type != "OUTLINE")
-			type = eType::Outline;
-
-		Edge edge;
-		edge.type = type;
-		edge.color = Color::FromString(message["edgeColor"].GetString());
-		return edge;
-	}
-
-	Media::TextTrackStyle::Font Media::TextTrackStyle::Font::FromMessage(const ConstJsonMessagePart& message)
-	{
-		eStyle style = eStyle::Normal;
-		std::string font_style = message["fontStyle"].GetString();
-		if (font_style != "NORMAL")
-			style = eStyle::Unknown;
-
-		Font font;
-		font.scale = message["fontScale"].GetDouble();
-		font.style = style;
-		font.family = message["fontFamily"].GetString();
-		font.generic_family = message["fontGenericFamily"].GetString();
-		return font;
-	}
-
-	Media::TextTrackStyle::Window Media::TextTrackStyle::Window::FromMessage(const ConstJsonMessagePart& message)
-	{
-		Window window;
-		window.color = Color::FromString(message["windowColor"].GetString());
-		window.rounded_corner_radius = message["windowRoundedCornerRadius"].GetDouble();
-		window.type = Window::eType::None;
-		return window;
-	}
-
-	Media::TextTrackStyle Media::TextTrackStyle::FromMessage(const ConstJsonMessagePart& message)
-	{
-		TextTrackStyle text_track_style;
-		text_track_style.background = Color::FromString(message["backgroundColor"].GetString());
-		text_track_style.foreground = Color::FromString(message["foregroundColor"].GetString());
-		text_track_style.edge = Edge::FromMessage(message);
-		text_track_style.font = Font::FromMessage(message);
-		text_track_style.window = Window::FromMessage(message);
-		return text_track_style;
-	}
-
-	Media::MetaData::Image::Image(std::string&& url)
-		: url(url)
-	{
-
-	}
-
-	void Media::MetaData::Image::ToMessage(JsonMessagePart& message) const
-	{
-		message["url"] = url;
-	}
-
-	Media::MetaData::Image Media::MetaData::Image::FromMessage(const ConstJsonMessagePart& message)
-	{
-		return Image(message["url"].GetString());
-	}
-
-	void Media::MetaData::ToMessage(JsonMessagePart& message) const
-	{
-		auto& metadata_part = message["metadata"];
-		metadata_part["type"] = type;
-		metadata_part["metadataType"] = (uint32_t)metadataType;
-		metadata_part["title"] = title;
-		auto& images_part = metadata_part["images"];
-		for (auto& image : images)
-			images_part["url"] = image.url;
-	}
-
-	Media::MetaData Media::MetaData::FromMessage(const ConstJsonMessagePart& message)
-	{
-		auto& meta_data_part = message["metadata"];
-		MetaData meta_data;
-		meta_data.type = meta_data_part["type"].GetUint32();
-		meta_data.title = meta_data_part["title"].GetString();
-		meta_data.metadataType = static_cast<eMetadataType>(meta_data_part["metadataType"].GetUint32());
-
-		auto& images_part = meta_data_part["images"];
-		for (size_t index = 0; index < images_part.Size(); ++index)
-			meta_data.images.push_back(Image::FromMessage(images_part[index]));
-		return meta_data;
-	}
-
-	void Media::ToMessage(JsonMessagePart& message) const
-	{
-		auto& json_media = message["media"];
-		json_media["contentId"] = content_id;
-		json_media["contentType"] = content_type;
-		json_media["streamType"] = stream_type == Media::eStreamType::BUFFERED ? "BUFFERED" : "LIVE";
-		json_media["tracks"] = tracks;
-		meta_data.ToMessage(message);
-	}
-
-	Media Media::FromMessage(const ConstJsonMessagePart& message)
-	{
-		Media media;
-		media.content_id = message["contentId"].GetString();
-		media.content_type = message["contentType"].GetString();
-
-		if (message.HasMember("tracks"))
-		{
-			auto& tracks_part = message["tracks"];
-			for (size_t index = 0; index < tracks_part.Size(); ++index)
-				media.tracks.push_back(Track::FromMessage(tracks_part[index]));
-		}
-		if (message.HasMember("textTrackStyle"))
-			media.text_track_style = TextTrackStyle::FromMessage(message);
-		if (message.HasMember("metadata"))
-			media.meta_data = MetaData::FromMessage(message);
-		return media;
-	}
-
-	MediaItem MediaItem::FromMessage(const ConstJsonMessagePart& message)
-	{
-		MediaItem item;
-		item.id = message["itemId"].GetUint32();
-		item.autoplay = message["autoplay"].GetBool();
-		item.start_time = message["startTime"].GetDouble();
-		auto& active_track_ids_message_part = message["activeTrackIds"];
-		for (size_t index = 0; index < active_track_ids_message_part.Size(); ++index)
-			item.active_track_ids.push_back(active_track_ids_message_part[index].GetUint32());
-		item.media = Media::FromMessage(message["media"]);
-		return item;
-	}
-
-	MediaStatus MediaStatus::FromMessage(const ConstJsonMessagePart& message)
-	{
-		std::string type = message["type"].GetString();
-		THROW_ON_ERROR_EX(type != "MEDIA_STATUS", "invalid message type, expected a receiver status message");
-
-		auto& json_statuses = message["status"];
-		std::vector<MediaStatus> statuses;
-		for (size_t index = 0; index < json_statuses.Size(); ++index)
-		{
-			auto& json_status = json_statuses[index];
-			MediaStatus status;
-			status.valid = true;
-			status.session_id = json_status["mediaSessionId"].GetUint32();
-			status.playback_rate = json_status["playbackRate"].GetUint32();
-			status.current_time = json_status["currentTime"].GetDouble();
-			status.supported_media_commands = (eSupportedCommands)(json_status["supportedMediaCommands"].GetUint32());
-
-			auto& volume = json_status["volume"];
-			status.muted = volume["muted"].GetBool();
-			status.volume_level = volume["level"].GetDouble();
-			status.current_item_id = json_status["currentItemId"].GetUint32();
-
-			std::string media_play_state = json_status["playerState"].GetString();
-			auto it_player_state = player_json_state_to_state.find(media_play_state);
-			THROW_ON_ERROR_EX(it_player_state == player_json_state_to_state.end(), "unrecognized play state " + media_play_state);
-			status.player_state = it_player_state->second;
-
-			if (json_status.HasMember("repeatMode"))
-			{
-				std::string media_repeat_mode = json_status["repeatMode"].GetString();
-				auto it_repeat_mode = player_json_repeat_mode_to_repeat_mode.find(media_repeat_mode);
-				THROW_ON_ERROR_EX(it_repeat_mode == player_json_repeat_mode_to_repeat_mode.end(), "unrecognized repeat mode " + media_repeat_mode);
-				status.repeat_mode = it_repeat_mode->second;
-			}
-			if (json_status.HasMember("media"))
-				status.media = Media::FromMessage(json_status["media"]);
-			if (json_status.HasMember("items"))
-			{
-				auto& items = json_status["items"];
-				for (size_t index = 0; index < items.Size(); ++index)
-					status.items.push_back(MediaItem::FromMessage(items[index]));
-			}
-
-			statuses.push_back(status);
-		}
-
-		MediaStatus status;
-		if (!statuses.empty())
-			status = statuses.front();
-		return status;
-	}
-
-	bool MediaResponse::Succeeded() const
-	{
-		return reason.empty();
-	}
-
-	bool MediaResponse::Failed() const
-	{
-		return !Succeeded();
-	}
-
-	void MediaResponse::ThrowOnFailure() const
-	{
-		if (Failed())
-			throw std::runtime_error(reason);
-	}
-
-	std::string MediaResponse::ToString() const
-	{
-		return reason.empty() ? "success" : "failure, " + reason;
-	}
-
-	const MediaStatus& MediaResponse::GetStatus() const
-	{
-		return status;
-	}
-
-	MediaResponse MediaResponse::FromMessage(const ConstJsonMessagePart& message)
-	{
-		MediaResponse result;
-		if (message.HasMember("status"))
-			result.status = MediaStatus::FromMessage(message);
-		else
-			result.reason = message["reason"].GetString();
-		return result;
-	}
+#include "media_messages.h"
+#include "json_message.h"
+#include "json_decoder.h"
+#include "json_fields.h"
+#include "json_writer.h"
+#include "utils.h"
+#include <boost\lexical_cast.hpp>
+#include <map>
+
+namespace chromecast
+{
+	static std::map<std::string, MediaStatus::ePlayerState> player_json_state_to_state = 
+	{
+		{ "PLAYING", MediaStatus::ePlayerState::Playing },
+		{ "BUFFERING", MediaStatus::ePlayerState::Buffering },
+		{ "PAUSED", MediaStatus::ePlayerState::Paused },
+		{ "IDLE", MediaStatus::ePlayerState::Idle }
+	};
+
+	static std::map<std::string, MediaStatus::eRepeatMode> player_json_repeat_mode_to_repeat_mode =
+	{
+		{ "REPEAT_OFF", MediaStatus::eRepeatMode::Off },
+	};
+
+	struct TrackTypeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::Track::eTrackType& type)
+		{
+			type = part.GetString() == "TEXT" ? Media::Track::eTrackType::Text : Media::Track::eTrackType::Unknown;
+		}
+
+		static void Write(JsonMessagePart& part, const Media::Track::eTrackType& type)
+		{
+			THROW_ON_ERROR_EX(type != Media::Track::eTrackType::Text, "unknown track type");
+			part = "TEXT";
+		}
+
+		static void Write(JsonWriter& writer, const Media::Track::eTrackType& type)
+		{
+			THROW_ON_ERROR_EX(type != Media::Track::eTrackType::Text, "unknown track type");
+			writer.Value("TEXT");
+		}
+	};
+
+	struct StreamTypeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::eStreamType& type)
+		{
+			type = part.GetString() == "LIVE" ? Media::eStreamType::LIVE : Media::eStreamType::BUFFERED;
+		}
+
+		static void Write(JsonMessagePart& part, const Media::eStreamType& type)
+		{
+			part = type == Media::eStreamType::BUFFERED ? "BUFFERED" : "LIVE";
+		}
+
+		static void Write(JsonWriter& writer, const Media::eStreamType& type)
+		{
+			writer.Value(type == Media::eStreamType::BUFFERED ? "BUFFERED" : "LIVE");
+		}
+	};
+
+	struct MetadataTypeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::MetaData::eMetadataType& type)
+		{
+			type = static_cast<Media::MetaData::eMetadataType>(part.GetUint32());
+		}
+
+		static void Write(JsonMessagePart& part, const Media::MetaData::eMetadataType& type)
+		{
+			part = static_cast<uint32_t>(type);
+		}
+
+		static void Write(JsonWriter& writer, const Media::MetaData::eMetadataType& type)
+		{
+			writer.Value(static_cast<uint32_t>(type));
+		}
+	};
+
+	struct ColorConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::TextTrackStyle::Color& color)
+		{
+			color = Media::TextTrackStyle::Color::FromString(part.GetString());
+		}
+
+		static void Write(JsonMessagePart& part, const Media::TextTrackStyle::Color& color)
+		{
+			part = color.ToString();
+		}
+
+		static void Write(JsonWriter& writer, const Media::TextTrackStyle::Color& color)
+		{
+			writer.Value(color.ToString());
+		}
+	};
+
+	struct EdgeTypeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::TextTrackStyle::Edge::eType& type)
+		{
+			type = part.GetString() == "OUTLINE" ? Media::TextTrackStyle::Edge::eType::Outline : Media::TextTrackStyle::Edge::eType::Unknown;
+		}
+
+		static void Write(JsonMessagePart& part, const Media::TextTrackStyle::Edge::eType& type)
+		{
+			THROW_ON_ERROR_EX(type != Media::TextTrackStyle::Edge::eType::Outline, "unknown edge type");
+			part = "OUTLINE";
+		}
+
+		static void Write(JsonWriter& writer, const Media::TextTrackStyle::Edge::eType& type)
+		{
+			THROW_ON_ERROR_EX(type != Media::TextTrackStyle::Edge::eType::Outline, "unknown edge type");
+			writer.Value("OUTLINE");
+		}
+	};
+
+	struct FontStyleConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, Media::TextTrackStyle::Font::eStyle& style)
+		{
+			style = part.GetString() == "NORMAL" ? Media::TextTrackStyle::Font::eStyle::Normal : Media::TextTrackStyle::Font::eStyle::Unknown;
+		}
+
+		static void Write(JsonMessagePart& part, const Media::TextTrackStyle::Font::eStyle& style)
+		{
+			THROW_ON_ERROR_EX(style != Media::TextTrackStyle::Font::eStyle::Normal, "unknown font style");
+			part = "NORMAL";
+		}
+
+		static void Write(JsonWriter& writer, const Media::TextTrackStyle::Font::eStyle& style)
+		{
+			THROW_ON_ERROR_EX(style != Media::TextTrackStyle::Font::eStyle::Normal, "unknown font style");
+			writer.Value("NORMAL");
+		}
+	};
+
+	//converts a member of the edge, font or window of a text track style, the message keeps them flat next to the colors of the style.
+	template <typename TMemberPointer, TMemberPointer member, typename TConverter>
+	struct StylePartConverter
+	{
+		template <typename TPart>
+		static void Read(const ConstJsonMessagePart& part, TPart& value)
+		{
+			TConverter::Read(part, value.*member);
+		}
+
+		template <typename TPart>
+		static void Write(JsonMessagePart& part, const TPart& value)
+		{
+			TConverter::Write(part, value.*member);
+		}
+
+		template <typename TPart>
+		static void Write(JsonWriter& writer, const TPart& value)
+		{
+			TConverter::Write(writer, value.*member);
+		}
+	};
+
+	typedef Media::TextTrackStyle::Edge TextTrackEdge;
+	typedef Media::TextTrackStyle::Font TextTrackFont;
+	typedef Media::TextTrackStyle::Window TextTrackWindow;
+	typedef StylePartConverter<decltype(&TextTrackEdge::type), &TextTrackEdge::type, EdgeTypeConverter> EdgeTypePartConverter;
+	typedef StylePartConverter<decltype(&TextTrackEdge::color), &TextTrackEdge::color, ColorConverter> EdgeColorPartConverter;
+	typedef StylePartConverter<decltype(&TextTrackFont::scale), &TextTrackFont::scale, JsonConverter<double>> FontScalePartConverter;
+	typedef StylePartConverter<decltype(&TextTrackFont::style), &TextTrackFont::style, FontStyleConverter> FontStylePartConverter;
+	typedef StylePartConverter<decltype(&TextTrackFont::family), &TextTrackFont::family, JsonConverter<std::string>> FontFamilyPartConverter;
+	typedef StylePartConverter<decltype(&TextTrackFont::generic_family), &TextTrackFont::generic_family, JsonConverter<std::string>> FontGenericFamilyPartConverter;
+	typedef StylePartConverter<decltype(&TextTrackWindow::color), &TextTrackWindow::color, ColorConverter> WindowColorPartConverter;
+	typedef StylePartConverter<decltype(&TextTrackWindow::rounded_corner_radius), &TextTrackWindow::rounded_corner_radius, JsonConverter<double>> WindowRadiusPartConverter;
+
+	template <typename TValue>
+	static const std::string& FindJsonName(const std::map<std::string, TValue>& values, const TValue& value, const char* description)
+	{
+		for (auto& entry : values)
+		{
+			if (entry.second == value)
+				return entry.first;
+		}
+		throw std::runtime_error(std::string("unknown ") + description);
+	}
+
+	struct PlayerStateConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, MediaStatus::ePlayerState& state)
+		{
+			std::string media_play_state = part.GetString();
+			auto it_player_state = player_json_state_to_state.find(media_play_state);
+			THROW_ON_ERROR_EX(it_player_state == player_json_state_to_state.end(), "unrecognized play state " + media_play_state);
+			state = it_player_state->second;
+		}
+
+		static void Write(JsonMessagePart& part, const MediaStatus::ePlayerState& state)
+		{
+			part = FindJsonName(player_json_state_to_state, state, "play state");
+		}
+
+		static void Write(JsonWriter& writer, const MediaStatus::ePlayerState& state)
+		{
+			writer.Value(FindJsonName(player_json_state_to_state, state, "play state"));
+		}
+	};
+
+	struct RepeatModeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, MediaStatus::eRepeatMode& mode)
+		{
+			std::string media_repeat_mode = part.GetString();
+			auto it_repeat_mode = player_json_repeat_mode_to_repeat_mode.find(media_repeat_mode);
+			THROW_ON_ERROR_EX(it_repeat_mode == player_json_repeat_mode_to_repeat_mode.end(), "unrecognized repeat mode " + media_repeat_mode);
+			mode = it_repeat_mode->second;
+		}
+
+		static void Write(JsonMessagePart& part, const MediaStatus::eRepeatMode& mode)
+		{
+			part = FindJsonName(player_json_repeat_mode_to_repeat_mode, mode, "repeat mode");
+		}
+
+		static void Write(JsonWriter& writer, const MediaStatus::eRepeatMode& mode)
+		{
+			writer.Value(FindJsonName(player_json_repeat_mode_to_repeat_mode, mode, "repeat mode"));
+		}
+	};
+
+	struct SupportedCommandsConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, MediaStatus::eSupportedCommands& commands)
+		{
+			commands = static_cast<MediaStatus::eSupportedCommands>(part.GetUint32());
+		}
+
+		static void Write(JsonMessagePart& part, const MediaStatus::eSupportedCommands& commands)
+		{
+			part = static_cast<uint32_t>(commands);
+		}
+
+		static void Write(JsonWriter& writer, const MediaStatus::eSupportedCommands& commands)
+		{
+			writer.Value(static_cast<uint32_t>(commands));
+		}
+	};
+
+	static const JsonFields<Media::Track> k_track_fields =
+	{
+		JSON_FIELD(Media::Track, id, "trackId"),
+		JSON_FIELD_EX(Media::Track, type, "type", true, TrackTypeConverter),
+		JSON_FIELD(Media::Track, content_id, "trackContentId"),
+		JSON_FIELD(Media::Track, content_type, "trackContentType"),
+		JSON_FIELD(Media::Track, name, "name"),
+		JSON_FIELD(Media::Track, language, "language"),
+		JSON_FIELD(Media::Track, sub_type, "subtype")
+	};
+
+	static const JsonFields<Media::TextTrackStyle> k_text_track_style_fields =
+	{
+		JSON_FIELD_EX(Media::TextTrackStyle, background, "backgroundColor", true, ColorConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, foreground, "foregroundColor", true, ColorConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, edge, "edgeType", true, EdgeTypePartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, edge, "edgeColor", true, EdgeColorPartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, font, "fontScale", true, FontScalePartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, font, "fontStyle", true, FontStylePartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, font, "fontFamily", true, FontFamilyPartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, font, "fontGenericFamily", true, FontGenericFamilyPartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, window, "windowColor", true, WindowColorPartConverter),
+		JSON_FIELD_EX(Media::TextTrackStyle, window, "windowRoundedCornerRadius", true, WindowRadiusPartConverter)
+	};
+
+	static const JsonFields<Media::MetaData::Image> k_image_fields =
+	{
+		JSON_FIELD(Media::MetaData::Image, url, "url")
+	};
+
+	static const JsonFields<Media::MetaData> k_meta_data_fields =
+	{
+		JSON_FIELD(Media::MetaData, type, "type"),
+		JSON_FIELD_EX(Media::MetaData, metadataType, "metadataType", true, MetadataTypeConverter),
+		JSON_FIELD(Media::MetaData, title, "title"),
+		JSON_FIELD(Media::MetaData, images, "images")
+	};
+
+	//the duration and the text track style are reported by the receiver, a load request leaves them out.
+	static const JsonFields<Media> k_media_fields =
+	{
+		JSON_FIELD(Media, content_id, "contentId"),
+		JSON_FIELD(Media, content_type, "contentType"),
+		JSON_FIELD_EX(Media, stream_type, "streamType", false, StreamTypeConverter),
+		JSON_OPTIONAL_FIELD(Media, tracks, "tracks"),
+		JSON_OPTIONAL_FIELD(Media, meta_data, "metadata"),
+		JSON_READ_ONLY_FIELD(Media, duration, "duration"),
+		JSON_READ_ONLY_FIELD(Media, text_track_style, "textTrackStyle")
+	};
+
+	static const JsonFields<MediaItem> k_media_item_fields =
+	{
+		JSON_FIELD(MediaItem, id, "itemId"),
+		JSON_FIELD(MediaItem, autoplay, "autoplay"),
+		JSON_FIELD(MediaItem, start_time, "startTime"),
+		JSON_FIELD(MediaItem, active_track_ids, "activeTrackIds"),
+		JSON_FIELD(MediaItem, media, "media")
+	};
+
+	static const JsonFields<MediaStatus> k_media_volume_fields =
+	{
+		JSON_FIELD(MediaStatus, volume_level, "level"),
+		JSON_FIELD(MediaStatus, muted, "muted")
+	};
+
+	struct MediaVolumeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, MediaStatus& status)
+		{
+			k_media_volume_fields.Read(part, status);
+		}
+
+		static void Write(JsonMessagePart& part, const MediaStatus& status)
+		{
+			k_media_volume_fields.Write(status, part);
+		}
+
+		static void Write(JsonWriter& writer, const MediaStatus& status)
+		{
+			k_media_volume_fields.Write(status, writer);
+		}
+	};
+
+	static const JsonFields<MediaStatus> k_media_status_fields =
+	{
+		JSON_FIELD(MediaStatus, session_id, "mediaSessionId"),
+		JSON_FIELD(MediaStatus, playback_rate, "playbackRate"),
+		JSON_FIELD_EX(MediaStatus, player_state, "playerState", true, PlayerStateConverter),
+		JSON_FIELD(MediaStatus, current_time, "currentTime"),
+		JSON_FIELD_EX(MediaStatus, supported_media_commands, "supportedMediaCommands", true, SupportedCommandsConverter),
+		JSON_NESTED_FIELD(MediaStatus, "volume", true, MediaVolumeConverter),
+		JSON_FIELD(MediaStatus, current_item_id, "currentItemId"),
+		JSON_FIELD_EX(MediaStatus, repeat_mode, "repeatMode", false, RepeatModeConverter),
+		JSON_OPTIONAL_FIELD(MediaStatus, media, "media"),
+		JSON_OPTIONAL_FIELD(MediaStatus, items, "items")
+	};
+
+	void Media::Track::ToMessage(JsonMessagePart& message) const
+	{
+		k_track_fields.Write(*this, message);
+	}
+
+	void Media::Track::ToMessage(JsonWriter& writer) const
+	{
+		k_track_fields.Write(*this, writer);
+	}
+
+	Media::Track Media::Track::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_track_fields.Read(message);
+	}
+
+	Media::TextTrackStyle::Color Media::TextTrackStyle::Color::FromString(const std::string& value)
+	{
+		if (value.length() != 9)
+			throw std::runtime_error("invalid color value " + value);
+
+		if (value.front() != '#')
+			throw std::runtime_error("color value does not start with a # prefix" + value);
+
+		size_t pos = 1;
+		const size_t color_channel_string_length = 2;
+		Color color;
+		for (auto& b : color.value.argb)
+		{
+			b = boost::lexical_cast<byte>(value.substr(pos, color_channel_string_length));
+			pos += color_channel_string_length;
+		}
+		return color;
+	}
+
+	std::string Media::TextTrackStyle::Color::ToString() const
+	{
+		static const char k_digits[] = "0123456789ABCDEF";
+		std::string text = "#";
+		for (byte b : value.argb)
+		{
+			text += k_digits[b >> 4];
+			text += k_digits[b & 0xf];
+		}
+		return text;
+	}
+
+	void Media::TextTrackStyle::ToMessage(JsonMessagePart& message) const
+	{
+		k_text_track_style_fields.Write(*this, message);
+	}
+
+	void Media::TextTrackStyle::ToMessage(JsonWriter& writer) const
+	{
+		k_text_track_style_fields.Write(*this, writer);
+	}
+
+	Media::TextTrackStyle Media::TextTrackStyle::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_text_track_style_fields.Read(message);
+	}
+
+	Media::MetaData::Image::Image(std::string&& url)
+		: url(url)
+	{
+
+	}
+
+	void Media::MetaData::Image::ToMessage(JsonMessagePart& message) const
+	{
+		k_image_fields.Write(*this, message);
+	}
+
+	void Media::MetaData::Image::ToMessage(JsonWriter& writer) const
+	{
+		k_image_fields.Write(*this, writer);
+	}
+
+	Media::MetaData::Image Media::MetaData::Image::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_image_fields.Read(message);
+	}
+
+	void Media::MetaData::ToMessage(JsonMessagePart& message) const
+	{
+		k_meta_data_fields.Write(*this, message);
+	}
+
+	void Media::MetaData::ToMessage(JsonWriter& writer) const
+	{
+		k_meta_data_fields.Write(*this, writer);
+	}
+
+	Media::MetaData Media::MetaData::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_meta_data_fields.Read(message);
+	}
+
+	void Media::ToMessage(JsonMessagePart& message) const
+	{
+		k_media_fields.Write(*this, message);
+	}
+
+	void Media::ToMessage(JsonWriter& writer) const
+	{
+		k_media_fields.Write(*this, writer);
+	}
+
+	Media Media::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_media_fields.Read(message);
+	}
+
+	void MediaItem::ToMessage(JsonMessagePart& message) const
+	{
+		k_media_item_fields.Write(*this, message);
+	}
+
+	void MediaItem::ToMessage(JsonWriter& writer) const
+	{
+		k_media_item_fields.Write(*this, writer);
+	}
+
+	MediaItem MediaItem::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_media_item_fields.Read(message);
+	}
+
+	MediaStatus MediaStatus::FromMessage(const ConstJsonMessagePart& message)
+	{
+		std::string type = message["type"].GetString();
+		THROW_ON_ERROR_EX(type != "MEDIA_STATUS", "invalid message type, expected a receiver status message");
+
+		//every status is checked, only the first one is kept.
+		auto& json_statuses = message["status"];
+		MediaStatus status;
+		for (size_t index = 0; index < json_statuses.Size(); ++index)
+		{
+			MediaStatus json_status;
+			k_media_status_fields.Read(json_statuses[index], json_status);
+			json_status.valid = true;
+			if (index == 0)
+				status = std::move(json_status);
+		}
+		return status;
+	}
+
+	namespace
+	{
+		template <typename TValue>
+		TValue FindJsonValue(const std::map<std::string, TValue>& values, const JsonScalar& value, const char* description)
+		{
+			std::string text = value.GetString();
+			auto it = values.find(text);
+			THROW_ON_ERROR_EX(it == values.end(), std::string("unrecognized ") + description + " " + text);
+			return it->second;
+		}
+
+		//the members FromMessage requires, the decoder targets check the same ones.
+		static const char* const k_track_members[] = { "trackId", "type", "trackContentId", "trackContentType", "name", "language", "subtype" };
+		static const char* const k_text_track_style_members[] = { "backgroundColor", "foregroundColor", "edgeType", "edgeColor", "fontScale", "fontStyle",
+			"fontFamily", "fontGenericFamily", "windowColor", "windowRoundedCornerRadius" };
+		static const char* const k_image_members[] = { "url" };
+		static const char* const k_meta_data_members[] = { "type", "metadataType", "title", "images" };
+		static const char* const k_media_members[] = { "contentId", "contentType" };
+		static const char* const k_media_item_members[] = { "itemId", "autoplay", "startTime", "activeTrackIds", "media" };
+		static const char* const k_volume_members[] = { "muted", "level" };
+		static const char* const k_media_status_members[] = { "mediaSessionId", "playbackRate", "currentTime", "supportedMediaCommands", "volume",
+			"currentItemId", "playerState" };
+		static const char* const k_media_status_message_members[] = { "type", "status" };
+
+		class UintArrayTarget : public JsonDecoder::Target
+		{
+			std::vector<uint32_t>* _values = nullptr;
+		public:
+			void Reset(std::vector<uint32_t>& values)
+			{
+				_values = &values;
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_values->push_back(value.GetUint32());
+			}
+		};
+
+		class TrackTarget : public JsonDecoder::Target
+		{
+			Media::Track* _track = nullptr;
+			JsonRequiredMembers _required;
+		public:
+			TrackTarget()
+				: _required(k_track_members)
+			{
+
+			}
+
+			void Reset(Media::Track& track)
+			{
+				_track = &track;
+				_track->type = Media::Track::eTrackType::Unknown;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "trackId")
+					_track->id = value.GetUint32();
+				else if (name == "type")
+					_track->type = value.Equals("TEXT") ? Media::Track::eTrackType::Text : Media::Track::eTrackType::Unknown;
+				else if (name == "trackContentId")
+					_track->content_id = value.GetString();
+				else if (name == "trackContentType")
+					_track->content_type = value.GetString();
+				else if (name == "name")
+					_track->name = value.GetString();
+				else if (name == "language")
+					_track->language = value.GetString();
+				else if (name == "subtype")
+					_track->sub_type = value.GetString();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class TextTrackStyleTarget : public JsonDecoder::Target
+		{
+			Media::TextTrackStyle* _style = nullptr;
+			JsonRequiredMembers _required;
+		public:
+			TextTrackStyleTarget()
+				: _required(k_text_track_style_members)
+			{
+
+			}
+
+			void Reset(Media::TextTrackStyle& style)
+			{
+				_style = &style;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				typedef Media::TextTrackStyle TextTrackStyle;
+				if (name == "backgroundColor")
+					_style->background = TextTrackStyle::Color::FromString(value.GetString());
+				else if (name == "foregroundColor")
+					_style->foreground = TextTrackStyle::Color::FromString(value.GetString());
+				else if (name == "edgeType")
+					_style->edge.type = value.Equals("OUTLINE") ? TextTrackStyle::Edge::eType::Outline : TextTrackStyle::Edge::eType::Unknown;
+				else if (name == "edgeColor")
+					_style->edge.color = TextTrackStyle::Color::FromString(value.GetString());
+				else if (name == "fontScale")
+					_style->font.scale = value.GetDouble();
+				else if (name == "fontStyle")
+					_style->font.style = value.Equals("NORMAL") ? TextTrackStyle::Font::eStyle::Normal : TextTrackStyle::Font::eStyle::Unknown;
+				else if (name == "fontFamily")
+					_style->font.family = value.GetString();
+				else if (name == "fontGenericFamily")
+					_style->font.generic_family = value.GetString();
+				else if (name == "windowColor")
+					_style->window.color = TextTrackStyle::Color::FromString(value.GetString());
+				else if (name == "windowRoundedCornerRadius")
+					_style->window.rounded_corner_radius = value.GetDouble();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class ImageTarget : public JsonDecoder::Target
+		{
+			Media::MetaData::Image* _image = nullptr;
+			JsonRequiredMembers _required;
+		public:
+			ImageTarget()
+				: _required(k_image_members)
+			{
+
+			}
+
+			void Reset(Media::MetaData::Image& image)
+			{
+				_image = &image;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "url")
+					_image->url = value.GetString();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class MetaDataTarget : public JsonDecoder::Target
+		{
+			Media::MetaData* _meta_data = nullptr;
+			JsonObjectArrayTarget<Media::MetaData::Image, ImageTarget> _images_target;
+			JsonRequiredMembers _required;
+		public:
+			MetaDataTarget()
+				: _required(k_meta_data_members)
+			{
+
+			}
+
+			void Reset(Media::MetaData& meta_data)
+			{
+				_meta_data = &meta_data;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "type")
+					_meta_data->type = value.GetUint32();
+				else if (name == "metadataType")
+					_meta_data->metadataType = static_cast<Media::MetaData::eMetadataType>(value.GetUint32());
+				else if (name == "title")
+					_meta_data->title = value.GetString();
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name != "images" || !is_array)
+					return nullptr;
+				_required.OnMember(name);
+				_images_target.Reset(_meta_data->images);
+				return &_images_target;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class MediaTarget : public JsonDecoder::Target
+		{
+			Media* _media = nullptr;
+			JsonObjectArrayTarget<Media::Track, TrackTarget> _tracks_target;
+			TextTrackStyleTarget _text_track_style_target;
+			MetaDataTarget _meta_data_target;
+			JsonRequiredMembers _required;
+		public:
+			MediaTarget()
+				: _required(k_media_members)
+			{
+
+			}
+
+			void Reset(Media& media)
+			{
+				_media = &media;
+				_media->duration = 0;
+				_media->stream_type = Media::eStreamType::BUFFERED;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "contentId")
+					_media->content_id = value.GetString();
+				else if (name == "contentType")
+					_media->content_type = value.GetString();
+				else if (name == "duration")
+					_media->duration = value.GetDouble();
+				else if (name == "streamType")
+					_media->stream_type = value.Equals("LIVE") ? Media::eStreamType::LIVE : Media::eStreamType::BUFFERED;
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name == "tracks" && is_array)
+				{
+					_tracks_target.Reset(_media->tracks);
+					return &_tracks_target;
+				}
+				if (name == "textTrackStyle" && !is_array)
+				{
+					_text_track_style_target.Reset(_media->text_track_style);
+					return &_text_track_style_target;
+				}
+				if (name == "metadata" && !is_array)
+				{
+					_meta_data_target.Reset(_media->meta_data);
+					return &_meta_data_target;
+				}
+				return nullptr;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class MediaItemTarget : public JsonDecoder::Target
+		{
+			MediaItem* _item = nullptr;
+			UintArrayTarget _active_track_ids_target;
+			MediaTarget _media_target;
+			JsonRequiredMembers _required;
+		public:
+			MediaItemTarget()
+				: _required(k_media_item_members)
+			{
+
+			}
+
+			void Reset(MediaItem& item)
+			{
+				_item = &item;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "itemId")
+					_item->id = value.GetUint32();
+				else if (name == "autoplay")
+					_item->autoplay = value.GetBool();
+				else if (name == "startTime")
+					_item->start_time = value.GetDouble();
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name == "activeTrackIds" && is_array)
+				{
+					_required.OnMember(name);
+					_active_track_ids_target.Reset(_item->active_track_ids);
+					return &_active_track_ids_target;
+				}
+				if (name == "media" && !is_array)
+				{
+					_required.OnMember(name);
+					_media_target.Reset(_item->media);
+					return &_media_target;
+				}
+				return nullptr;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class MediaVolumeTarget : public JsonDecoder::Target
+		{
+			MediaStatus& _status;
+			JsonRequiredMembers _required;
+		public:
+			MediaVolumeTarget(MediaStatus& status)
+				: _status(status),
+				_required(k_volume_members)
+			{
+
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "muted")
+					_status.muted = value.GetBool();
+				else if (name == "level")
+					_status.volume_level = value.GetDouble();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class MediaStatusTarget : public JsonDecoder::Target
+		{
+			MediaStatus& _status;
+			MediaVolumeTarget _volume_target;
+			MediaTarget _media_target;
+			JsonObjectArrayTarget<MediaItem, MediaItemTarget> _items_target;
+			JsonRequiredMembers _required;
+		public:
+			MediaStatusTarget(MediaStatus& status)
+				: _status(status),
+				_volume_target(status),
+				_required(k_media_status_members)
+			{
+				_media_target.Reset(status.media);
+				_items_target.Reset(status.items);
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "mediaSessionId")
+					_status.session_id = value.GetUint32();
+				else if (name == "playbackRate")
+					_status.playback_rate = value.GetUint32();
+				else if (name == "currentTime")
+					_status.current_time = value.GetDouble();
+				else if (name == "supportedMediaCommands")
+					_status.supported_media_commands = (MediaStatus::eSupportedCommands)value.GetUint32();
+				else if (name == "currentItemId")
+					_status.current_item_id = value.GetUint32();
+				else if (name == "playerState")
+					_status.player_state = FindJsonValue(player_json_state_to_state, value, "play state");
+				else if (name == "repeatMode")
+					_status.repeat_mode = FindJsonValue(player_json_repeat_mode_to_repeat_mode, value, "repeat mode");
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name == "volume" && !is_array)
+				{
+					_required.OnMember(name);
+					return &_volume_target;
+				}
+				if (name == "media" && !is_array)
+					return &_media_target;
+				if (name == "items" && is_array)
+					return &_items_target;
+				return nullptr;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		//only the first status is decoded, as in MediaStatus::FromMessage.
+		class MediaStatusesTarget : public JsonDecoder::Target
+		{
+			MediaStatusTarget _status_target;
+			MediaStatus& _status;
+		public:
+			MediaStatusesTarget(MediaStatus& status)
+				: _status_target(status),
+				_status(status)
+			{
+
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (is_array || _status.valid)
+					return nullptr;
+				_status.valid = true;
+				return &_status_target;
+			}
+		};
+
+		class MediaStatusMessageTarget : public JsonDecoder::Target
+		{
+			MediaStatusesTarget _statuses_target;
+			JsonRequiredMembers _required;
+		public:
+			std::string type;
+
+			MediaStatusMessageTarget(MediaStatus& status)
+				: _statuses_target(status),
+				_required(k_media_status_message_members)
+			{
+
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "type")
+					type = value.GetString();
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name != "status" || !is_array)
+					return nullptr;
+				_required.OnMember(name);
+				return &_statuses_target;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+	}
+
+	MediaStatus MediaStatus::FromJson(const boost::string_ref& json)
+	{
+		MediaStatus status;
+		MediaStatusMessageTarget target(status);
+		JsonDecoder::Decode(json, target);
+		//the type may come after the status, it is only checked once the whole message was read.
+		THROW_ON_ERROR_EX(target.type != "MEDIA_STATUS", "invalid message type, expected a media status message");
+		return status;
+	}
+
+	bool MediaResponse::Succeeded() const
+	{
+		return reason.empty();
+	}
+
+	bool MediaResponse::Failed() const
+	{
+		return !Succeeded();
+	}
+
+	void MediaResponse::ThrowOnFailure() const
+	{
+		if (Failed())
+			throw std::runtime_error(reason);
+	}
+
+	std::string MediaResponse::ToString() const
+	{
+		return reason.empty() ? "success" : "failure, " + reason;
+	}
+
+	const MediaStatus& MediaResponse::GetStatus() const
+	{
+		return status;
+	}
+
+	MediaResponse MediaResponse::FromMessage(const ConstJsonMessagePart& message)
+	{
+		MediaResponse result;
+		if (message.HasMember("status"))
+			result.status = MediaStatus::FromMessage(message);
+		else
+			result.reason = message["reason"].GetString();
+		return result;
+	}
 };
\ No newline at end of file
@@ -1,104 +1,401 @@
-#include "receiver_messages.h"
-#include "json_message.h"
-#include "utils.h"
-
-namespace chromecast
-{
-	using namespace rapidjson;
-
-	static const std::string k_receiver_status = "RECEIVER_STATUS";
-	static const std::string k_invalid_request = "INVALID_REQUEST";
-
-	BasicReceiverStatus::BasicReceiverStatus(BasicReceiverStatus&& other)
-	{
-		muted = other.muted;
-		volume_level = other.volume_level;
-		is_standby = other.is_standby;
-		is_active_input = move(other.is_active_input);
-	}
-
-	BasicReceiverStatus& BasicReceiverStatus::operator=(const BasicReceiverStatus& other)
-	{
-		muted = other.muted;
-		volume_level = other.volume_level;
-		is_standby = other.is_standby;
-		if (other.is_active_input)
-			is_active_input = std::make_unique<bool>(*other.is_active_input);
-		return *this;
-	}
-
-	BasicReceiverStatus BasicReceiverStatus::FromMessage(const ConstJsonMessagePart& message)
-	{
-		BasicReceiverStatus status;
-		auto& volume = message["volume"];
-		status.muted = volume["muted"].GetBool();
-		status.volume_level = volume["level"].GetDouble();
-
-		status.is_standby = message["isStandBy"].GetBool();
-		if (message.HasMember("isActiveInput"))
-			status.is_active_input = std::make_unique<bool>(message["isActiveInput"].GetBool());
-		return status;
-	}
-
-	ReceiverStatus::ApplicationInfo ReceiverStatus::ApplicationInfo::FromMessage(const ConstJsonMessagePart& message)
-	{
-		ApplicationInfo app_info;
-		app_info.application_id = message["appId"].GetString();
-		app_info.display_name = message["displayName"].GetString();
-		app_info.session_id = message["sessionId"].GetString();
-		app_info.status_text = message["statusText"].GetString();
-		if (message.HasMember("transportId"))
-			app_info.transport_id = message["transportId"].GetString();
-		auto& namespaces_value = message["namespaces"];
-		size_t index = 0;
-		app_info.namespaces.resize(namespaces_value.Size());
-		for (std::string& namespace_id : app_info.namespaces)
-			namespace_id = namespaces_value[index++]["name"].GetString();
-		return app_info;
-	}
-
-	ReceiverStatus::ReceiverStatus(ReceiverStatus&& other)
-	{
-		static_cast<BasicReceiverStatus&>(*this) = std::move(other);
-		applications = move(other.applications);
-	}
-
-	ReceiverStatus ReceiverStatus::FromMessage(const ConstJsonMessagePart& message)
-	{
-		std::string type = message["type"].GetString();
-		THROW_ON_ERROR_EX(type != k_receiver_status, "invalid message type, expected a receiver status message instead of the following message: " + message.ToString());
-
-		auto& status_message = message["status"];
-		ReceiverStatus status;
-		static_cast<BasicReceiverStatus&>(status) = BasicReceiverStatus::FromMessage(status_message);
-		if (status_message.HasMember("applications"))
-		{
-			auto& applications_value = status_message["applications"];
-			size_t index = 0;
-			status.applications.resize(applications_value.Size());
-			for (auto& app : status.applications)
-				app = ApplicationInfo::FromMessage(applications_value[index]);
-		}
-		return status;
-	}
-
-	ReceiverResponse::ReceiverResponse(ReceiverResponse&& other)
-		: status(std::move(other.status)),
-		reason(move(other.reason))
-	{
-
-	}
-
-	ReceiverResponse FromMessage(const ConstJsonMessagePart& message)
-	{
-		ReceiverResponse response;
-		std::string type = message["type"].GetString();
-		if (type == k_receiver_status)
-			response.status = ReceiverStatus::FromMessage(message);
-		else if (type == k_invalid_request)
-			response.reason = message["reason"].GetString();
-		else
-			THROW_ON_ERROR_EX(true, "unrecognized receiver response: " + message.ToString());
-		return response;
-	}
+#include "receiver_messages.h"
+#include "json_message.h"
+#include "json_decoder.h"
+#include "json_fields.h"
+#include "utils.h"
+
+namespace chromecast
+{
+	using namespace rapidjson;
+
+	static const std::string k_receiver_status = "RECEIVER_STATUS";
+	static const std::string k_invalid_request = "INVALID_REQUEST";
+
+	BasicReceiverStatus::BasicReceiverStatus(BasicReceiverStatus&& other)
+	{
+		muted = other.muted;
+		volume_level = other.volume_level;
+		is_standby = other.is_standby;
+		is_active_input = move(other.is_active_input);
+	}
+
+	BasicReceiverStatus& BasicReceiverStatus::operator=(const BasicReceiverStatus& other)
+	{
+		muted = other.muted;
+		volume_level = other.volume_level;
+		is_standby = other.is_standby;
+		if (other.is_active_input)
+			is_active_input = std::make_unique<bool>(*other.is_active_input);
+		return *this;
+	}
+
+	//the namespaces of an application are objects that only carry a name.
+	struct NamespacesConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, std::vector<std::string>& namespaces)
+		{
+			namespaces.resize(part.Size());
+			for (size_t index = 0; index < namespaces.size(); ++index)
+				namespaces[index] = part[index]["name"].GetString();
+		}
+
+		static void Write(JsonMessagePart& part, const std::vector<std::string>& namespaces)
+		{
+			part.Resize(namespaces.size());
+			for (size_t index = 0; index < namespaces.size(); ++index)
+				part[index]["name"] = namespaces[index];
+		}
+
+		static void Write(JsonWriter& writer, const std::vector<std::string>& namespaces)
+		{
+			writer.StartArray();
+			for (const std::string& namespace_id : namespaces)
+				writer.StartObject().Member("name", namespace_id).EndObject();
+			writer.EndArray();
+		}
+	};
+
+	//a missing active input flag is written as false.
+	struct ActiveInputConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, std::unique_ptr<bool>& is_active_input)
+		{
+			is_active_input = std::make_unique<bool>(part.GetBool());
+		}
+
+		static void Write(JsonMessagePart& part, const std::unique_ptr<bool>& is_active_input)
+		{
+			part = is_active_input && *is_active_input;
+		}
+
+		static void Write(JsonWriter& writer, const std::unique_ptr<bool>& is_active_input)
+		{
+			writer.Value(is_active_input && *is_active_input);
+		}
+	};
+
+	static const JsonFields<BasicReceiverStatus> k_volume_fields =
+	{
+		JSON_FIELD(BasicReceiverStatus, volume_level, "level"),
+		JSON_FIELD(BasicReceiverStatus, muted, "muted")
+	};
+
+	struct VolumeConverter
+	{
+		static void Read(const ConstJsonMessagePart& part, BasicReceiverStatus& status)
+		{
+			k_volume_fields.Read(part, status);
+		}
+
+		static void Write(JsonMessagePart& part, const BasicReceiverStatus& status)
+		{
+			k_volume_fields.Write(status, part);
+		}
+
+		static void Write(JsonWriter& writer, const BasicReceiverStatus& status)
+		{
+			k_volume_fields.Write(status, writer);
+		}
+	};
+
+	static const JsonFields<BasicReceiverStatus> k_basic_receiver_status_fields =
+	{
+		JSON_NESTED_FIELD(BasicReceiverStatus, "volume", true, VolumeConverter),
+		JSON_FIELD(BasicReceiverStatus, is_standby, "isStandBy"),
+		JSON_FIELD_EX(BasicReceiverStatus, is_active_input, "isActiveInput", false, ActiveInputConverter)
+	};
+
+	BasicReceiverStatus BasicReceiverStatus::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_basic_receiver_status_fields.Read(message);
+	}
+
+	static const JsonFields<ReceiverStatus::ApplicationInfo> k_application_info_fields =
+	{
+		JSON_FIELD(ReceiverStatus::ApplicationInfo, application_id, "appId"),
+		JSON_FIELD(ReceiverStatus::ApplicationInfo, display_name, "displayName"),
+		JSON_FIELD(ReceiverStatus::ApplicationInfo, session_id, "sessionId"),
+		JSON_FIELD(ReceiverStatus::ApplicationInfo, status_text, "statusText"),
+		JSON_OPTIONAL_FIELD(ReceiverStatus::ApplicationInfo, transport_id, "transportId"),
+		JSON_FIELD_EX(ReceiverStatus::ApplicationInfo, namespaces, "namespaces", true, NamespacesConverter)
+	};
+
+	//the members of the base status are declared again, a single walk over the status also finds the applications.
+	static const JsonFields<ReceiverStatus> k_receiver_status_fields =
+	{
+		JSON_NESTED_FIELD(ReceiverStatus, "volume", true, VolumeConverter),
+		JSON_FIELD(ReceiverStatus, is_standby, "isStandBy"),
+		JSON_FIELD_EX(ReceiverStatus, is_active_input, "isActiveInput", false, ActiveInputConverter),
+		JSON_OPTIONAL_FIELD(ReceiverStatus, applications, "applications")
+	};
+
+	void ReceiverStatus::ApplicationInfo::ToMessage(JsonMessagePart& message) const
+	{
+		k_application_info_fields.Write(*this, message);
+	}
+
+	void ReceiverStatus::ApplicationInfo::ToMessage(JsonWriter& writer) const
+	{
+		k_application_info_fields.Write(*this, writer);
+	}
+
+	ReceiverStatus::ApplicationInfo ReceiverStatus::ApplicationInfo::FromMessage(const ConstJsonMessagePart& message)
+	{
+		return k_application_info_fields.Read(message);
+	}
+
+	ReceiverStatus::ReceiverStatus(const ReceiverStatus& other)
+	{
+		*this = other;
+	}
+
+	ReceiverStatus::ReceiverStatus(ReceiverStatus&& other)
+	{
+		static_cast<BasicReceiverStatus&>(*this) = std::move(other);
+		applications = move(other.applications);
+	}
+
+	ReceiverStatus& ReceiverStatus::operator=(const ReceiverStatus& other)
+	{
+		static_cast<BasicReceiverStatus&>(*this) = other;
+		applications = other.applications;
+		return *this;
+	}
+
+	ReceiverStatus ReceiverStatus::FromMessage(const ConstJsonMessagePart& message)
+	{
+		std::string type = message["type"].GetString();
+		THROW_ON_ERROR_EX(type != k_receiver_status, "invalid message type, expected a receiver status message instead of the following message: " + message.ToString());
+
+		ReceiverStatus status;
+		k_receiver_status_fields.Read(message["status"], status);
+		return status;
+	}
+
+	namespace
+	{
+		//the members FromMessage requires, the decoder targets check the same ones.
+		static const char* const k_namespace_members[] = { "name" };
+		static const char* const k_application_info_members[] = { "appId", "displayName", "sessionId", "statusText", "namespaces" };
+		static const char* const k_volume_members[] = { "muted", "level" };
+		static const char* const k_receiver_status_members[] = { "volume", "isStandBy" };
+		static const char* const k_receiver_status_message_members[] = { "type", "status" };
+
+		//the namespaces of an application are objects that only carry a name.
+		class NamespaceTarget : public JsonDecoder::Target
+		{
+			std::string* _namespace_id = nullptr;
+			JsonRequiredMembers _required;
+		public:
+			NamespaceTarget()
+				: _required(k_namespace_members)
+			{
+
+			}
+
+			void Reset(std::string& namespace_id)
+			{
+				_namespace_id = &namespace_id;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "name")
+					*_namespace_id = value.GetString();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class ApplicationInfoTarget : public JsonDecoder::Target
+		{
+			ReceiverStatus::ApplicationInfo* _app_info = nullptr;
+			JsonObjectArrayTarget<std::string, NamespaceTarget> _namespaces_target;
+			JsonRequiredMembers _required;
+		public:
+			ApplicationInfoTarget()
+				: _required(k_application_info_members)
+			{
+
+			}
+
+			void Reset(ReceiverStatus::ApplicationInfo& app_info)
+			{
+				_app_info = &app_info;
+				_required.Reset();
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "appId")
+					_app_info->application_id = value.GetString();
+				else if (name == "displayName")
+					_app_info->display_name = value.GetString();
+				else if (name == "sessionId")
+					_app_info->session_id = value.GetString();
+				else if (name == "statusText")
+					_app_info->status_text = value.GetString();
+				else if (name == "transportId")
+					_app_info->transport_id = value.GetString();
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name != "namespaces" || !is_array)
+					return nullptr;
+				_required.OnMember(name);
+				_namespaces_target.Reset(_app_info->namespaces);
+				return &_namespaces_target;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class VolumeTarget : public JsonDecoder::Target
+		{
+			BasicReceiverStatus& _status;
+			JsonRequiredMembers _required;
+		public:
+			VolumeTarget(BasicReceiverStatus& status)
+				: _status(status),
+				_required(k_volume_members)
+			{
+
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "muted")
+					_status.muted = value.GetBool();
+				else if (name == "level")
+					_status.volume_level = value.GetDouble();
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class ReceiverStatusTarget : public JsonDecoder::Target
+		{
+			ReceiverStatus& _status;
+			VolumeTarget _volume_target;
+			JsonObjectArrayTarget<ReceiverStatus::ApplicationInfo, ApplicationInfoTarget> _applications_target;
+			JsonRequiredMembers _required;
+		public:
+			ReceiverStatusTarget(ReceiverStatus& status)
+				: _status(status),
+				_volume_target(status),
+				_required(k_receiver_status_members)
+			{
+				_applications_target.Reset(status.applications);
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "isStandBy")
+					_status.is_standby = value.GetBool();
+				else if (name == "isActiveInput")
+					_status.is_active_input = std::make_unique<bool>(value.GetBool());
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name == "volume" && !is_array)
+				{
+					_required.OnMember(name);
+					return &_volume_target;
+				}
+				if (name == "applications" && is_array)
+					return &_applications_target;
+				return nullptr;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+
+		class ReceiverStatusMessageTarget : public JsonDecoder::Target
+		{
+			ReceiverStatusTarget _status_target;
+			JsonRequiredMembers _required;
+		public:
+			std::string type;
+
+			ReceiverStatusMessageTarget(ReceiverStatus& status)
+				: _status_target(status),
+				_required(k_receiver_status_message_members)
+			{
+
+			}
+
+			void OnScalar(const boost::string_ref& name, const JsonScalar& value) override
+			{
+				_required.OnMember(name);
+				if (name == "type")
+					type = value.GetString();
+			}
+
+			JsonDecoder::Target* OnNested(const boost::string_ref& name, bool is_array) override
+			{
+				if (name != "status" || is_array)
+					return nullptr;
+				_required.OnMember(name);
+				return &_status_target;
+			}
+
+			void OnEnd() override
+			{
+				_required.Check();
+			}
+		};
+	}
+
+	ReceiverStatus ReceiverStatus::FromJson(const boost::string_ref& json)
+	{
+		ReceiverStatus status;
+		status.is_standby = false;
+		status.muted = false;
+		status.volume_level = 0;
+
+		//the type may come after the status, it is only checked once the whole message was read.
+		ReceiverStatusMessageTarget target(status);
+		JsonDecoder::Decode(json, target);
+		THROW_ON_ERROR_EX(target.type != k_receiver_status, "invalid message type, expected a receiver status message instead of the following message: " + json.to_string());
+		return status;
+	}
+
+	ReceiverResponse::ReceiverResponse(ReceiverResponse&& other)
+		: status(std::move(other.status)),
+		reason(move(other.reason))
+	{
+
+	}
+
+	ReceiverResponse FromMessage(const ConstJsonMessagePart& message)
+	{
+		ReceiverResponse response;
+		std::string type = message["type"].GetString();
+		if (type == k_receiver_status)
+			response.status = ReceiverStatus::FromMessage(message);
+		else if (type == k_invalid_request)
+			response.reason = message["reason"].GetString();
+		else
+			THROW_ON_ERROR_EX(true, "unrecognized receiver response: " + message.ToString());
+		return response;
+	}
 }
\ No newline at end of file
@@ -1,57 +1,66 @@
-#pragma once
-#include "types.h"
-#include <vector>
-#include <string>
-#include <memory>
-
-namespace chromecast
-{
-	class ConstJsonMessagePart;
-	struct BasicReceiverStatus
-	{
-		std::unique_ptr<bool> is_active_input;
-		bool is_standby;
-		bool muted;
-		double volume_level;
-
-		BasicReceiverStatus() = default;
-		BasicReceiverStatus(BasicReceiverStatus&& other);
-		BasicReceiverStatus& operator=(const BasicReceiverStatus& other);
-		static BasicReceiverStatus FromMessage(const ConstJsonMessagePart& message);
-	};
-
-	struct ReceiverStatus : public BasicReceiverStatus
-	{
-		struct ApplicationInfo
-		{
-			std::string application_id;
-			std::string display_name;
-			std::vector<std::string> namespaces;
-			std::string session_id;
-			std::string status_text;
-			std::string transport_id;
-
-			static ApplicationInfo FromMessage(const ConstJsonMessagePart& message);
-		};
-
-		std::vector<ApplicationInfo> applications;
-
-		ReceiverStatus() = default;
-		ReceiverStatus(ReceiverStatus&& other);
-
-		static ReceiverStatus FromMessage(const ConstJsonMessagePart& message);
-	};
-
-	struct ReceiverResponse
-	{
-		std::string reason;
-		ReceiverStatus status;
-
-		ReceiverResponse() = default;
-		ReceiverResponse(ReceiverResponse&& other);
-
-		static ReceiverResponse FromMessage(const ConstJsonMessagePart& message);
-	};
-
-	typedef std::pair<std::string, bool> AppAvailability;
+#pragma once
+#include "types.h"
+#include <vector>
+#include <string>
+#include <memory>
+#include <boost\utility\string_ref.hpp>
+
+namespace chromecast
+{
+	class JsonWriter;
+	class JsonMessagePart;
+	class ConstJsonMessagePart;
+	struct BasicReceiverStatus
+	{
+		std::unique_ptr<bool> is_active_input;
+		bool is_standby;
+		bool muted;
+		double volume_level;
+
+		BasicReceiverStatus() = default;
+		BasicReceiverStatus(BasicReceiverStatus&& other);
+		BasicReceiverStatus& operator=(const BasicReceiverStatus& other);
+		static BasicReceiverStatus FromMessage(const ConstJsonMessagePart& message);
+	};
+
+	struct ReceiverStatus : public BasicReceiverStatus
+	{
+		struct ApplicationInfo
+		{
+			std::string application_id;
+			std::string display_name;
+			std::vector<std::string> namespaces;
+			std::string session_id;
+			std::string status_text;
+			std::string transport_id;
+
+			void ToMessage(JsonMessagePart& message) const;
+			void ToMessage(JsonWriter& writer) const;
+			static ApplicationInfo FromMessage(const ConstJsonMessagePart& message);
+		};
+
+		std::vector<ApplicationInfo> applications;
+
+		ReceiverStatus() = default;
+		ReceiverStatus(const ReceiverStatus& other);
+		ReceiverStatus(ReceiverStatus&& other);
+		ReceiverStatus& operator=(const ReceiverStatus& other);
+
+		static ReceiverStatus FromMessage(const ConstJsonMessagePart& message);
+		//decodes the status straight from the payload text without building a json document, requires the same members as FromMessage.
+		static ReceiverStatus FromJson(const boost::string_ref& json);
+	};
+
+	struct ReceiverResponse
+	{
+		std::string reason;
+		ReceiverStatus status;
+
+		ReceiverResponse() = default;
+		ReceiverResponse(ReceiverResponse&& other);
+
+		static ReceiverResponse FromMessage(const ConstJsonMessagePart& message);
+	};
+
+	typedef std::pair<std::string, bool> AppAvailability;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "tls_context.h"
+#include "utils.h"
+
+namespace chromecast
+{
+	using namespace std;
+
+	static unique_ptr<TLSContext> s_default_context;
+	static once_flag s_default_context_flag;
+
+	TLSContext::TLSContext()
+		: _context(boost::asio::ssl::context::tlsv12_client)
+	{
+		//chromecast devices use self signed certificates.
+		_context.set_verify_mode(boost::asio::ssl::verify_none);
+		SSL_CTX_set_session_cache_mode(_context.native_handle(), SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+	}
+
+	TLSContext::~TLSContext()
+	{
+		ClearSessionCache();
+	}
+
+	TLSContext& TLSContext::GetDefault()
+	{
+		call_once(s_default_context_flag, []()
+		{
+			s_default_context = make_unique<TLSContext>();
+		});
+		return *s_default_context;
+	}
+
+	boost::asio::ssl::context& TLSContext::GetContext()
+	{
+		return _context;
+	}
+
+	void TLSContext::SetCipherList(const std::string& cipher_list)
+	{
+		THROW_ON_ERROR_EX(SSL_CTX_set_cipher_list(_context.native_handle(), cipher_list.c_str()) != 1, "invalid cipher list: " + cipher_list);
+	}
+
+	void TLSContext::SetVerifyMode(boost::asio::ssl::verify_mode verify_mode)
+	{
+		_context.set_verify_mode(verify_mode);
+	}
+
+	void TLSContext::SetSessionCacheEnabled(bool enabled)
+	{
+		{
+			lock_guard<mutex> lock(_mutex);
+			_session_cache_enabled = enabled;
+		}
+		if (!enabled)
+			ClearSessionCache();
+	}
+
+	void TLSContext::ClearSessionCache()
+	{
+		lock_guard<mutex> lock(_mutex);
+		for (auto& end_point_to_session : _end_point_to_session)
+			SSL_SESSION_free(end_point_to_session.second);
+		_end_point_to_session.clear();
+		_statistics.cached_sessions = 0;
+	}
+
+	void TLSContext::PrepareHandshake(SSL* ssl, const boost::asio::ip::tcp::endpoint& end_point)
+	{
+		lock_guard<mutex> lock(_mutex);
+		if (!_session_cache_enabled)
+			return;
+
+		auto it = _end_point_to_session.find(end_point);
+		if (it != _end_point_to_session.end())
+			SSL_set_session(ssl, it->second);
+	}
+
+	void TLSContext::OnHandshakeCompleted(SSL* ssl, const boost::asio::ip::tcp::endpoint& end_point)
+	{
+		bool resumed = SSL_session_reused(ssl) != 0;
+
+		lock_guard<mutex> lock(_mutex);
+		++_statistics.handshakes;
+		if (resumed)
+			++_statistics.resumed_handshakes;
+		//checked under the lock, so a session is never cached after the cache was disabled and cleared.
+		if (!_session_cache_enabled)
+			return;
+		SSL_SESSION* session = SSL_get1_session(ssl);
+		if (!session)
+			return;
+
+		SSL_SESSION*& cached_session = _end_point_to_session[end_point];
+		if (cached_session)
+			SSL_SESSION_free(cached_session);
+		cached_session = session;
+		_statistics.cached_sessions = _end_point_to_session.size();
+	}
+
+	TLSContext::Statistics TLSContext::GetStatistics()
+	{
+		lock_guard<mutex> lock(_mutex);
+		return _statistics;
+	}
+}
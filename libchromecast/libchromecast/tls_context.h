@@ -0,0 +1,53 @@
+#pragma once
+#include "types.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <boost\noncopyable.hpp>
+#include <boost\asio\ip\tcp.hpp>
+#include <boost\asio\ssl\context.hpp>
+
+namespace chromecast
+{
+	//ssl context shared by connections, also caches the tls session of every device so reconnecting can resume it with an abbreviated handshake.
+	class TLSContext
+	{
+	public:
+		struct Statistics
+		{
+			uint64_t handshakes = 0;
+			uint64_t resumed_handshakes = 0;
+			uint64_t cached_sessions = 0;
+		};
+	private:
+		boost::noncopyable _non_copyable;
+		boost::asio::ssl::context _context;
+
+		//guards the session cache and whether it is enabled, handshakes of different connections complete on different threads.
+		std::mutex _mutex;
+		bool _session_cache_enabled = true;
+		std::map<boost::asio::ip::tcp::endpoint, SSL_SESSION*> _end_point_to_session;
+		Statistics _statistics;
+	public:
+		TLSContext();
+		~TLSContext();
+
+		//the context used by connections that were not given one.
+		static TLSContext& GetDefault();
+
+		boost::asio::ssl::context& GetContext();
+
+		void SetCipherList(const std::string& cipher_list);
+		void SetVerifyMode(boost::asio::ssl::verify_mode verify_mode);
+		void SetSessionCacheEnabled(bool enabled);
+		void ClearSessionCache();
+
+		//called before the handshake with the given end point, offers its cached session for resumption.
+		void PrepareHandshake(SSL* ssl, const boost::asio::ip::tcp::endpoint& end_point);
+		//called after a successful handshake, counts whether the session was resumed and caches it for the next connection.
+		void OnHandshakeCompleted(SSL* ssl, const boost::asio::ip::tcp::endpoint& end_point);
+
+		Statistics GetStatistics();
+	};
+}
@@ -1,8 +1,8 @@
-#pragma once
-#include <inttypes.h>
-
-namespace chromecast
-{
-	typedef unsigned char byte;
-	//typedef unsigned int uint32_t;
+#pragma once
+#include <inttypes.h>
+
+namespace chromecast
+{
+	typedef unsigned char byte;
+	//typedef unsigned int uint32_t;
 }
\ No newline at end of file
@@ -0,0 +1,60 @@
+// mock-receiver.cpp : runs a stand-in cast receiver on the loopback interface.
+//
+
+#include "stdafx.h"
+#include <thread>
+#include <vector>
+#include <iostream>
+#include <boost/asio.hpp>
+#include <boost/lexical_cast.hpp>
+#include "mock_receiver.h"
+
+int main(int argc, char* argv[])
+{
+	try
+	{
+		if (argc > 5)
+		{
+			std::cerr << "Usage: " << argv[0] << " [port] [response-latency-ms] [media-status-broadcasts-per-second] [threads]\n" << std::endl;
+			return 1;
+		}
+
+		chromecast::MockReceiver::Options options;
+		if (argc > 1)
+			options.port = boost::lexical_cast<uint16_t>(argv[1]);
+		if (argc > 2)
+			options.response_latency_milliseconds = boost::lexical_cast<uint32_t>(argv[2]);
+		if (argc > 3)
+			options.media_status_broadcasts_per_second = boost::lexical_cast<uint32_t>(argv[3]);
+		size_t thread_count = argc > 4 ? boost::lexical_cast<size_t>(argv[4]) : 1;
+
+		boost::asio::io_service io_service;
+		chromecast::MockReceiver receiver(io_service, options);
+		receiver.Start();
+		std::cout << "listening on " << options.address << ":" << receiver.GetPort() << std::endl;
+
+		boost::asio::signal_set signals(io_service, SIGINT, SIGTERM);
+		signals.async_wait([&](const boost::system::error_code& error, int signal_number)
+		{
+			receiver.Stop();
+			io_service.stop();
+		});
+
+		std::vector<std::thread> threads;
+		for (size_t index = 1; index < thread_count; ++index)
+			threads.emplace_back([&]() { io_service.run(); });
+		io_service.run();
+		for (auto& thread : threads)
+			thread.join();
+
+		auto statistics = receiver.GetStatistics();
+		std::cout << "connections: " << statistics.connections_accepted << std::endl;
+		std::cout << "messages received: " << statistics.messages_received << std::endl;
+		std::cout << "messages sent: " << statistics.messages_sent << std::endl;
+		std::cout << "broadcasts sent: " << statistics.broadcasts_sent << std::endl;
+	}
+	catch (std::exception& e)
+	{
+		std::cerr << "Error:\n" << e.what() << "\n";
+	}
+}
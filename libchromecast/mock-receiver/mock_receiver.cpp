@@ -0,0 +1,678 @@
+#include "mock_receiver.h"
+#include "../libchromecast/cast_message.h"
+#include "../libchromecast/json_message.h"
+#include "../libchromecast/utils.h"
+
+#include <set>
+#include <chrono>
+#include <vector>
+#include <boost/bind.hpp>
+#include <boost/endian/arithmetic.hpp>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include <openssl/x509.h>
+
+namespace chromecast
+{
+	using namespace std;
+
+	static const std::string k_connection_namespace = "urn:x-cast:com.google.cast.tp.connection";
+	static const std::string k_heartbeat_namespace = "urn:x-cast:com.google.cast.tp.heartbeat";
+	static const std::string k_receiver_namespace = "urn:x-cast:com.google.cast.receiver";
+	static const std::string k_media_namespace = "urn:x-cast:com.google.cast.media";
+	static const std::string k_receiver0 = "receiver-0";
+	static const std::string k_broadcast_destination = "*";
+	static const std::string k_default_media_receiver = "CC1AD845";
+	static const uint32_t k_max_frame_size = 64 * 1024;
+
+	class MockReceiver::Session : public std::enable_shared_from_this<Session>
+	{
+		typedef boost::asio::ssl::stream<boost::asio::ip::tcp::socket> socket_type;
+
+		boost::asio::io_service& _io_service;
+		socket_type _socket;
+		boost::asio::io_service::strand _strand;
+		Options _options;
+		std::shared_ptr<Counters> _counters;
+		bool _started = false;
+		bool _closed = false;
+
+		std::vector<byte> _read_buffer;
+		size_t _read_end = 0;
+
+		//frames are encoded back to back into _pending_frames while a write is in flight.
+		std::vector<byte> _write_in_flight;
+		std::vector<byte> _pending_frames;
+
+		boost::asio::deadline_timer _broadcast_timer;
+		std::chrono::steady_clock::time_point _broadcast_start;
+		uint64_t _broadcasts_due = 0;
+
+		std::set<std::string> _connected_senders;
+
+		//state of the emulated device.
+		double _volume_level = 1;
+		bool _muted = false;
+		uint32_t _application_count = 0;
+		std::string _app_id;
+		std::string _session_id;
+		std::string _transport_id;
+
+		uint32_t _media_session_id = 0;
+		uint32_t _media_session_count = 0;
+		std::string _player_state = "IDLE";
+		std::string _content_id;
+		std::string _content_type;
+		double _duration = 0;
+		double _current_time = 0;
+		std::chrono::steady_clock::time_point _playing_since;
+
+		void OnHandshake(const boost::system::error_code& error);
+		void StartReading();
+		void OnDataRead(const boost::system::error_code& error, size_t bytes_transferred);
+		void OnMessage(const CastMessageView& message);
+
+		void OnConnectionMessage(const CastMessageView& message, const JsonMessage& request);
+		void OnHeartbeatMessage(const CastMessageView& message, const JsonMessage& request);
+		void OnReceiverMessage(const CastMessageView& message, JsonMessage& request);
+		void OnMediaMessage(const CastMessageView& message, JsonMessage& request);
+
+		void BuildReceiverStatus(JsonMessage& message, uint64_t request_id);
+		void BuildMediaStatus(JsonMessage& message, uint64_t request_id);
+		void BuildInvalidRequest(JsonMessage& message, uint64_t request_id, const char* reason);
+		double GetCurrentTime() const;
+		void StopApplication();
+
+		void Reply(const CastMessageView& request, const JsonMessage& response);
+		void Broadcast(const std::string& source, const std::string& name_space, const JsonMessage& message);
+		void Send(const std::string& source, const std::string& destination, const std::string& name_space, const std::string& payload);
+		void StartWriting();
+		void OnWriteCompleted(const boost::system::error_code& error);
+
+		void StartBroadcastTimer();
+		void OnBroadcastTimer(const boost::system::error_code& error);
+	public:
+		Session(boost::asio::io_service& io_service, boost::asio::ssl::context& ssl_context, const Options& options, std::shared_ptr<Counters> counters);
+		~Session();
+
+		socket_type::lowest_layer_type& GetSocket();
+		void Start();
+		void Close();
+	};
+
+	MockReceiver::Counters::Counters()
+		: connections_accepted(0),
+		active_connections(0),
+		messages_received(0),
+		messages_sent(0),
+		broadcasts_sent(0)
+	{
+	}
+
+	MockReceiver::Session::Session(boost::asio::io_service& io_service, boost::asio::ssl::context& ssl_context, const Options& options, std::shared_ptr<Counters> counters)
+		: _io_service(io_service),
+		_socket(io_service, ssl_context),
+		_strand(io_service),
+		_options(options),
+		_counters(counters),
+		_read_buffer(sizeof(uint32_t) + k_max_frame_size),
+		_broadcast_timer(io_service)
+	{
+	}
+
+	MockReceiver::Session::~Session()
+	{
+		if (_started)
+			--_counters->active_connections;
+	}
+
+	MockReceiver::Session::socket_type::lowest_layer_type& MockReceiver::Session::GetSocket()
+	{
+		return _socket.lowest_layer();
+	}
+
+	void MockReceiver::Session::Start()
+	{
+		_started = true;
+		++_counters->active_connections;
+		_socket.async_handshake(boost::asio::ssl::stream_base::server, _strand.wrap(boost::bind(&Session::OnHandshake, shared_from_this(), boost::asio::placeholders::error)));
+	}
+
+	void MockReceiver::Session::Close()
+	{
+		auto self = shared_from_this();
+		_strand.dispatch([self]()
+		{
+			self->_closed = true;
+			self->_broadcast_timer.cancel();
+			boost::system::error_code error;
+			self->_socket.lowest_layer().close(error);
+		});
+	}
+
+	void MockReceiver::Session::OnHandshake(const boost::system::error_code& error)
+	{
+		if (error)
+			return;
+		StartReading();
+		StartBroadcastTimer();
+	}
+
+	void MockReceiver::Session::StartReading()
+	{
+		_socket.async_read_some(boost::asio::buffer(_read_buffer.data() + _read_end, _read_buffer.size() - _read_end), _strand.wrap(boost::bind(&Session::OnDataRead, shared_from_this(), boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred)));
+	}
+
+	void MockReceiver::Session::OnDataRead(const boost::system::error_code& error, size_t bytes_transferred)
+	{
+		if (error || _closed)
+			return Close();
+
+		_read_end += bytes_transferred;
+		size_t read_begin = 0;
+		boost::endian::big_uint32_t packet_length;
+		while (_read_end - read_begin >= sizeof(packet_length))
+		{
+			memcpy(&packet_length, _read_buffer.data() + read_begin, sizeof(packet_length));
+			if (packet_length > k_max_frame_size)
+				return Close();
+
+			size_t frame_size = sizeof(packet_length) + packet_length;
+			if (_read_end - read_begin < frame_size)
+				break;
+
+			CastMessageView message;
+			if (!message.Parse(_read_buffer.data() + read_begin + sizeof(packet_length), packet_length))
+				return Close();
+			read_begin += frame_size;
+			++_counters->messages_received;
+			OnMessage(message);
+		}
+
+		memmove(_read_buffer.data(), _read_buffer.data() + read_begin, _read_end - read_begin);
+		_read_end -= read_begin;
+		if (!_closed)
+			StartReading();
+	}
+
+	void MockReceiver::Session::OnMessage(const CastMessageView& message)
+	{
+		if (message.payload_type != CastMessage::ePayloadType::String)
+			return;
+
+		JsonMessage request;
+		request.Parse(message.payload_utf8);
+		if (!request.HasMember("type"))
+			return;
+
+		if (message.address._namespace == k_connection_namespace)
+			OnConnectionMessage(message, request);
+		else if (message.address._namespace == k_heartbeat_namespace)
+			OnHeartbeatMessage(message, request);
+		else if (message.address._namespace == k_receiver_namespace)
+			OnReceiverMessage(message, request);
+		else if (message.address._namespace == k_media_namespace)
+			OnMediaMessage(message, request);
+	}
+
+	void MockReceiver::Session::OnConnectionMessage(const CastMessageView& message, const JsonMessage& request)
+	{
+		std::string type = request["type"].GetString();
+		std::string sender = message.address._source.to_string() + "/" + message.address._destination.to_string();
+		if (type == "CONNECT")
+			_connected_senders.insert(sender);
+		else if (type == "CLOSE")
+			_connected_senders.erase(sender);
+	}
+
+	void MockReceiver::Session::OnHeartbeatMessage(const CastMessageView& message, const JsonMessage& request)
+	{
+		if (request["type"].GetString() != "PING")
+			return;
+
+		JsonMessage pong;
+		pong["type"] = "PONG";
+		Send(message.address._destination.to_string(), message.address._source.to_string(), k_heartbeat_namespace, pong.ToString());
+	}
+
+	void MockReceiver::Session::OnReceiverMessage(const CastMessageView& message, JsonMessage& request)
+	{
+		std::string type = request["type"].GetString();
+		uint64_t request_id = request.HasMember("requestId") ? request["requestId"].GetUint64() : 0;
+
+		JsonMessage response;
+		bool status_changed = false;
+		if (type == "GET_STATUS")
+		{
+			BuildReceiverStatus(response, request_id);
+		}
+		else if (type == "LAUNCH")
+		{
+			StopApplication();
+			++_application_count;
+			_app_id = request["appId"].GetString();
+			_session_id = "mock-session-" + to_string(_application_count);
+			_transport_id = "web-" + to_string(_application_count);
+			BuildReceiverStatus(response, request_id);
+			status_changed = true;
+		}
+		else if (type == "STOP")
+		{
+			StopApplication();
+			BuildReceiverStatus(response, request_id);
+			status_changed = true;
+		}
+		else if (type == "SET_VOLUME")
+		{
+			auto volume = request["volume"];
+			if (volume.HasMember("level"))
+				_volume_level = volume["level"].GetDouble();
+			if (volume.HasMember("muted"))
+				_muted = volume["muted"].GetBool();
+			BuildReceiverStatus(response, request_id);
+			status_changed = true;
+		}
+		else if (type == "GET_APP_AVAILABILITY")
+		{
+			//object keys are not copied by the json message, the ids have to live until the response was serialized.
+			std::vector<std::string> app_ids;
+			auto app_ids_part = request["appId"];
+			for (size_t index = 0; index < app_ids_part.Size(); ++index)
+				app_ids.push_back(app_ids_part[index].GetString());
+
+			response["responseType"] = "GET_APP_AVAILABILITY";
+			response["requestId"] = request_id;
+			auto availability = response["availability"];
+			for (auto& app_id : app_ids)
+				availability[app_id.c_str()] = "APP_AVAILABLE";
+			Reply(message, response);
+			return;
+		}
+		else
+		{
+			BuildInvalidRequest(response, request_id, "INVALID_COMMAND");
+		}
+
+		Reply(message, response);
+		//a real receiver announces status changes to every sender, the client relies on it to initialize a launched application.
+		if (status_changed)
+		{
+			JsonMessage status;
+			BuildReceiverStatus(status, 0);
+			Broadcast(k_receiver0, k_receiver_namespace, status);
+		}
+	}
+
+	void MockReceiver::Session::OnMediaMessage(const CastMessageView& message, JsonMessage& request)
+	{
+		std::string type = request["type"].GetString();
+		uint64_t request_id = request.HasMember("requestId") ? request["requestId"].GetUint64() : 0;
+
+		JsonMessage response;
+		if (_transport_id.empty() || message.address._destination != _transport_id)
+		{
+			BuildInvalidRequest(response, request_id, "INVALID_PLAYER_STATE");
+			return Reply(message, response);
+		}
+
+		if (type == "LOAD")
+		{
+			auto media = request["media"];
+			_media_session_id = ++_media_session_count;
+			_content_id = media["contentId"].GetString();
+			_content_type = media["contentType"].GetString();
+			_duration = media.HasMember("duration") ? media["duration"].GetDouble() : 600;
+			_current_time = request.HasMember("currentTime") ? request["currentTime"].GetDouble() : 0;
+			bool autoplay = !request.HasMember("autoplay") || request["autoplay"].GetBool();
+			_player_state = autoplay ? "PLAYING" : "PAUSED";
+			_playing_since = std::chrono::steady_clock::now();
+			BuildMediaStatus(response, request_id);
+		}
+		else if (type == "GET_STATUS")
+		{
+			BuildMediaStatus(response, request_id);
+		}
+		else if (_media_session_id == 0 || !request.HasMember("mediaSessionId") || request["mediaSessionId"].GetUint32() != _media_session_id)
+		{
+			BuildInvalidRequest(response, request_id, "INVALID_MEDIA_SESSION_ID");
+		}
+		else if (type == "PLAY" || type == "PAUSE" || type == "SEEK" || type == "STOP")
+		{
+			_current_time = GetCurrentTime();
+			_playing_since = std::chrono::steady_clock::now();
+			if (type == "PLAY")
+				_player_state = "PLAYING";
+			else if (type == "PAUSE")
+				_player_state = "PAUSED";
+			else if (type == "SEEK")
+				_current_time = request["currentTime"].GetDouble();
+			else
+			{
+				_player_state = "IDLE";
+				_media_session_id = 0;
+			}
+			BuildMediaStatus(response, request_id);
+		}
+		else
+		{
+			BuildInvalidRequest(response, request_id, "INVALID_COMMAND");
+		}
+
+		Reply(message, response);
+		if (type != "GET_STATUS" && response["type"].GetString() == "MEDIA_STATUS")
+		{
+			JsonMessage status;
+			BuildMediaStatus(status, 0);
+			Broadcast(_transport_id, k_media_namespace, status);
+		}
+	}
+
+	void MockReceiver::Session::BuildReceiverStatus(JsonMessage& message, uint64_t request_id)
+	{
+		message["type"] = "RECEIVER_STATUS";
+		message["requestId"] = request_id;
+		auto status = message["status"];
+		auto volume = status["volume"];
+		volume["level"] = _volume_level;
+		volume["muted"] = _muted;
+		status["isStandBy"] = false;
+		status["isActiveInput"] = true;
+
+		auto applications = status["applications"];
+		applications.Resize(1);
+		if (_session_id.empty())
+			return;
+
+		size_t index = 0;
+		auto application = applications[index];
+		application["appId"] = _app_id;
+		application["displayName"] = _app_id == k_default_media_receiver ? "Default Media Receiver" : _app_id;
+		application["sessionId"] = _session_id;
+		application["statusText"] = "Ready To Cast";
+		application["transportId"] = _transport_id;
+		auto namespaces = application["namespaces"];
+		namespaces.Resize(1);
+		namespaces[index]["name"] = k_media_namespace;
+	}
+
+	void MockReceiver::Session::BuildMediaStatus(JsonMessage& message, uint64_t request_id)
+	{
+		message["type"] = "MEDIA_STATUS";
+		message["requestId"] = request_id;
+		auto statuses = message["status"];
+		statuses.Resize(1);
+		if (_media_session_id == 0)
+			return;
+
+		size_t index = 0;
+		auto status = statuses[index];
+		status["mediaSessionId"] = _media_session_id;
+		status["playbackRate"] = static_cast<uint32_t>(1);
+		status["playerState"] = _player_state;
+		status["currentTime"] = GetCurrentTime();
+		status["supportedMediaCommands"] = static_cast<uint32_t>(15);
+		status["currentItemId"] = static_cast<uint32_t>(1);
+		auto volume = status["volume"];
+		volume["level"] = _volume_level;
+		volume["muted"] = _muted;
+		auto media = status["media"];
+		media["contentId"] = _content_id;
+		media["contentType"] = _content_type;
+		media["streamType"] = "BUFFERED";
+		media["duration"] = _duration;
+	}
+
+	void MockReceiver::Session::BuildInvalidRequest(JsonMessage& message, uint64_t request_id, const char* reason)
+	{
+		message["type"] = "INVALID_REQUEST";
+		message["requestId"] = request_id;
+		message["reason"] = reason;
+	}
+
+	double MockReceiver::Session::GetCurrentTime() const
+	{
+		if (_player_state != "PLAYING")
+			return _current_time;
+		std::chrono::duration<double> playing = std::chrono::steady_clock::now() - _playing_since;
+		return (std::min)(_duration, _current_time + playing.count());
+	}
+
+	void MockReceiver::Session::StopApplication()
+	{
+		_app_id.clear();
+		_session_id.clear();
+		_transport_id.clear();
+		_media_session_id = 0;
+		_player_state = "IDLE";
+	}
+
+	void MockReceiver::Session::Reply(const CastMessageView& request, const JsonMessage& response)
+	{
+		std::string source = request.address._destination.to_string();
+		std::string destination = request.address._source.to_string();
+		std::string name_space = request.address._namespace.to_string();
+		std::string payload = response.ToString();
+		if (_options.response_latency_milliseconds == 0)
+			return Send(source, destination, name_space, payload);
+
+		auto self = shared_from_this();
+		auto timer = std::make_shared<boost::asio::deadline_timer>(_io_service, boost::posix_time::milliseconds(_options.response_latency_milliseconds));
+		timer->async_wait(_strand.wrap([self, timer, source, destination, name_space, payload](const boost::system::error_code& error)
+		{
+			if (!error)
+				self->Send(source, destination, name_space, payload);
+		}));
+	}
+
+	void MockReceiver::Session::Broadcast(const std::string& source, const std::string& name_space, const JsonMessage& message)
+	{
+		++_counters->broadcasts_sent;
+		Send(source, k_broadcast_destination, name_space, message.ToString());
+	}
+
+	void MockReceiver::Session::Send(const std::string& source, const std::string& destination, const std::string& name_space, const std::string& payload)
+	{
+		if (_closed)
+			return;
+
+		CastMessage message;
+		message.address = CastMessage::Address(source, destination, name_space);
+		message.payload_type = CastMessage::ePayloadType::String;
+		message.payload_utf8 = payload;
+
+		size_t message_size = message.GetEncodedSize();
+		size_t offset = _pending_frames.size();
+		_pending_frames.resize(offset + sizeof(uint32_t) + message_size);
+		boost::endian::big_uint32_t packet_length = static_cast<uint32_t>(message_size);
+		memcpy(_pending_frames.data() + offset, &packet_length, sizeof(packet_length));
+		message.Encode(_pending_frames.data() + offset + sizeof(packet_length));
+		++_counters->messages_sent;
+		StartWriting();
+	}
+
+	void MockReceiver::Session::StartWriting()
+	{
+		if (!_write_in_flight.empty() || _pending_frames.empty())
+			return;
+
+		_write_in_flight.swap(_pending_frames);
+		boost::asio::async_write(_socket, boost::asio::buffer(_write_in_flight), _strand.wrap(boost::bind(&Session::OnWriteCompleted, shared_from_this(), boost::asio::placeholders::error)));
+	}
+
+	void MockReceiver::Session::OnWriteCompleted(const boost::system::error_code& error)
+	{
+		_write_in_flight.clear();
+		if (error)
+			return Close();
+		StartWriting();
+	}
+
+	void MockReceiver::Session::StartBroadcastTimer()
+	{
+		if (_options.media_status_broadcasts_per_second == 0)
+			return;
+
+		_broadcast_start = std::chrono::steady_clock::now();
+		_broadcasts_due = 0;
+		_broadcast_timer.expires_from_now(boost::posix_time::milliseconds(1));
+		_broadcast_timer.async_wait(_strand.wrap(boost::bind(&Session::OnBroadcastTimer, shared_from_this(), boost::asio::placeholders::error)));
+	}
+
+	void MockReceiver::Session::OnBroadcastTimer(const boost::system::error_code& error)
+	{
+		if (error || _closed)
+			return;
+
+		//timers are too coarse for high rates, each tick sends every broadcast that became due since the start.
+		std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - _broadcast_start;
+		uint64_t due = static_cast<uint64_t>(elapsed.count() * _options.media_status_broadcasts_per_second);
+		if (_media_session_id != 0)
+		{
+			JsonMessage status;
+			BuildMediaStatus(status, 0);
+			std::string payload = status.ToString();
+			for (; _broadcasts_due < due; ++_broadcasts_due)
+			{
+				++_counters->broadcasts_sent;
+				Send(_transport_id, k_broadcast_destination, k_media_namespace, payload);
+			}
+		}
+		_broadcasts_due = due;
+
+		uint32_t interval_microseconds = (std::max)(1000u, 1000 * 1000 / _options.media_status_broadcasts_per_second);
+		_broadcast_timer.expires_from_now(boost::posix_time::microseconds(interval_microseconds));
+		_broadcast_timer.async_wait(_strand.wrap(boost::bind(&Session::OnBroadcastTimer, shared_from_this(), boost::asio::placeholders::error)));
+	}
+
+	MockReceiver::MockReceiver(boost::asio::io_service& io_service, const Options& options)
+		: _io_service(io_service),
+		_options(options),
+		_ssl_context(boost::asio::ssl::context::tlsv12_server),
+		_acceptor(io_service),
+		_strand(io_service),
+		_counters(std::make_shared<Counters>())
+	{
+		if (_options.certificate_file.empty())
+		{
+			UseSelfSignedCertificate();
+		}
+		else
+		{
+			_ssl_context.use_certificate_chain_file(_options.certificate_file);
+			_ssl_context.use_private_key_file(_options.private_key_file, boost::asio::ssl::context::pem);
+		}
+	}
+
+	MockReceiver::~MockReceiver()
+	{
+		//no handler of the receiver runs anymore, the acceptor is closed right away.
+		CloseAcceptor();
+		CloseSessions();
+	}
+
+	void MockReceiver::UseSelfSignedCertificate()
+	{
+		//senders do not verify the receiver certificate, any certificate completes the handshake.
+		std::unique_ptr<EVP_PKEY, decltype(&EVP_PKEY_free)> key(EVP_PKEY_new(), &EVP_PKEY_free);
+		std::unique_ptr<BIGNUM, decltype(&BN_free)> exponent(BN_new(), &BN_free);
+		RSA* rsa = RSA_new();
+		THROW_ON_ERROR_EX(!key || !exponent || !rsa || BN_set_word(exponent.get(), RSA_F4) != 1, "failed to allocate the certificate key");
+		THROW_ON_ERROR_EX(RSA_generate_key_ex(rsa, 2048, exponent.get(), nullptr) != 1 || EVP_PKEY_assign_RSA(key.get(), rsa) != 1, "failed to generate the certificate key");
+
+		std::unique_ptr<X509, decltype(&X509_free)> certificate(X509_new(), &X509_free);
+		THROW_ON_ERROR_EX(!certificate, "failed to allocate the certificate");
+		X509_set_version(certificate.get(), 2);
+		ASN1_INTEGER_set(X509_get_serialNumber(certificate.get()), 1);
+		X509_gmtime_adj(X509_get_notBefore(certificate.get()), 0);
+		X509_gmtime_adj(X509_get_notAfter(certificate.get()), 60 * 60 * 24 * 365);
+		X509_set_pubkey(certificate.get(), key.get());
+		X509_NAME* name = X509_get_subject_name(certificate.get());
+		X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("mock-receiver"), -1, -1, 0);
+		X509_set_issuer_name(certificate.get(), name);
+		THROW_ON_ERROR_EX(X509_sign(certificate.get(), key.get(), EVP_sha256()) == 0, "failed to sign the certificate");
+
+		THROW_ON_ERROR_EX(SSL_CTX_use_certificate(_ssl_context.native_handle(), certificate.get()) != 1, "failed to use the certificate");
+		THROW_ON_ERROR_EX(SSL_CTX_use_PrivateKey(_ssl_context.native_handle(), key.get()) != 1, "failed to use the certificate key");
+	}
+
+	void MockReceiver::Start()
+	{
+		boost::asio::ip::tcp::endpoint end_point(boost::asio::ip::address::from_string(_options.address), _options.port);
+		_acceptor.open(end_point.protocol());
+		_acceptor.set_option(boost::asio::ip::tcp::acceptor::reuse_address(true));
+		_acceptor.bind(end_point);
+		_acceptor.listen();
+		StartAccepting();
+	}
+
+	void MockReceiver::Stop()
+	{
+		//a connection accepted before the acceptor is closed is still in the sessions closed after it.
+		_strand.post([this]()
+		{
+			CloseAcceptor();
+			CloseSessions();
+		});
+	}
+
+	void MockReceiver::CloseAcceptor()
+	{
+		boost::system::error_code error;
+		_acceptor.close(error);
+	}
+
+	void MockReceiver::CloseSessions()
+	{
+		std::lock_guard<std::mutex> lock(_sessions_mutex);
+		for (auto& weak_session : _sessions)
+		{
+			auto session = weak_session.lock();
+			if (session)
+				session->Close();
+		}
+		_sessions.clear();
+	}
+
+	void MockReceiver::StartAccepting()
+	{
+		auto session = std::make_shared<Session>(_io_service, _ssl_context, _options, _counters);
+		_acceptor.async_accept(session->GetSocket(), _strand.wrap(boost::bind(&MockReceiver::OnAccepted, this, session, boost::asio::placeholders::error)));
+	}
+
+	void MockReceiver::OnAccepted(std::shared_ptr<Session> session, const boost::system::error_code& error)
+	{
+		//the acceptor was closed by Stop, an accept started on it would fail right away again.
+		if (!_acceptor.is_open())
+			return;
+
+		if (!error)
+		{
+			boost::system::error_code option_error;
+			session->GetSocket().set_option(boost::asio::ip::tcp::no_delay(true), option_error);
+			++_counters->connections_accepted;
+			{
+				std::lock_guard<std::mutex> lock(_sessions_mutex);
+				_sessions.remove_if([](const std::weak_ptr<Session>& weak_session) { return weak_session.expired(); });
+				_sessions.push_back(session);
+			}
+			session->Start();
+		}
+		StartAccepting();
+	}
+
+	uint16_t MockReceiver::GetPort() const
+	{
+		return _acceptor.local_endpoint().port();
+	}
+
+	MockReceiver::Statistics MockReceiver::GetStatistics() const
+	{
+		Statistics statistics;
+		statistics.connections_accepted = _counters->connections_accepted;
+		statistics.active_connections = _counters->active_connections;
+		statistics.messages_received = _counters->messages_received;
+		statistics.messages_sent = _counters->messages_sent;
+		statistics.broadcasts_sent = _counters->broadcasts_sent;
+		return statistics;
+	}
+}
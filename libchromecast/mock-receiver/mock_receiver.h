@@ -0,0 +1,87 @@
+#pragma once
+#include "../libchromecast/types.h"
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <boost\asio.hpp>
+#include <boost\asio\ssl.hpp>
+#include <boost\noncopyable.hpp>
+
+namespace chromecast
+{
+	struct MockReceiverOptions
+	{
+		std::string address = "127.0.0.1";
+		//zero binds an ephemeral port, GetPort returns the chosen one.
+		uint16_t port = 8009;
+		//delay before a request is answered, broadcasts and heartbeats are not delayed.
+		uint32_t response_latency_milliseconds = 0;
+		//MEDIA_STATUS broadcasts per second while a media session exists, zero only broadcasts on state changes.
+		uint32_t media_status_broadcasts_per_second = 0;
+		//pem files of the server certificate, a self signed certificate is generated when they are empty.
+		std::string certificate_file;
+		std::string private_key_file;
+	};
+
+	//stands in for a cast device so the client stack can be exercised without hardware.
+	//speaks the length prefixed CASTV2 framing over tls and answers the connection, heartbeat, receiver and media namespaces.
+	//every accepted connection gets a receiver of its own, so connections never observe each others applications or media sessions.
+	class MockReceiver
+	{
+	public:
+		typedef MockReceiverOptions Options;
+
+		struct Statistics
+		{
+			uint64_t connections_accepted = 0;
+			uint64_t active_connections = 0;
+			uint64_t messages_received = 0;
+			uint64_t messages_sent = 0;
+			uint64_t broadcasts_sent = 0;
+		};
+	private:
+		class Session;
+		struct Counters
+		{
+			std::atomic<uint64_t> connections_accepted;
+			std::atomic<uint64_t> active_connections;
+			std::atomic<uint64_t> messages_received;
+			std::atomic<uint64_t> messages_sent;
+			std::atomic<uint64_t> broadcasts_sent;
+
+			Counters();
+		};
+
+		boost::noncopyable _non_copyable;
+
+		boost::asio::io_service& _io_service;
+		Options _options;
+		boost::asio::ssl::context _ssl_context;
+		boost::asio::ip::tcp::acceptor _acceptor;
+		//the accept handlers and the close of the acceptor run on this strand.
+		boost::asio::io_service::strand _strand;
+		std::shared_ptr<Counters> _counters;
+
+		std::mutex _sessions_mutex;
+		std::list<std::weak_ptr<Session>> _sessions;
+
+		void UseSelfSignedCertificate();
+		void StartAccepting();
+		void OnAccepted(std::shared_ptr<Session> session, const boost::system::error_code& error);
+		void CloseAcceptor();
+		void CloseSessions();
+	public:
+		MockReceiver(boost::asio::io_service& io_service, const Options& options = Options());
+		~MockReceiver();
+
+		void Start();
+		//stops accepting and closes every connection on the io service, the destructor closes them right away if it did not run.
+		void Stop();
+
+		uint16_t GetPort() const;
+		Statistics GetStatistics() const;
+	};
+}